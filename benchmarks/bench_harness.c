@@ -0,0 +1,534 @@
+#define _DEFAULT_SOURCE         /* wait4 and struct rusage alongside the POSIX calls. */
+
+#include <stdio.h>        /* FILE, printf, fprintf, perror. */
+#include <stdlib.h>       /* strtod / strtoull / exit codes. */
+#include <string.h>       /* strcmp / strchr / snprintf helpers. */
+#include <stdint.h>       /* uint64_t sizes and counters. */
+#include <stdbool.h>      /* bool flags. */
+#include <time.h>         /* clock_gettime for wall time. */
+#include <fcntl.h>        /* open() for the child's stdin/stdout. */
+#include <unistd.h>       /* fork / execv / dup2 / access. */
+#include <sys/stat.h>     /* stat to reuse existing corpora. */
+#include <sys/wait.h>     /* wait4 status macros. */
+#include <sys/resource.h> /* struct rusage for peak RSS. */
+
+/*
+ * Benchmark harness for the practicals.
+ *
+ * Usage:
+ *   ./bench_harness generate <c|html|log|ident> <size> <file>
+ *   ./bench_harness run [--bin-dir DIR] [--corpus-dir DIR] [--sizes 1M,100M,1G]
+ *                       [--repeat N] [--only TOOL] [--threshold PCT]
+ *                       [--baseline FILE] [--update-baseline]
+ *
+ * generate writes a deterministic synthetic corpus: the same kind and size
+ * always give the same bytes. Sizes take a K, M or G suffix (powers of 1024).
+ * Next to each corpus a ".tokens" file records how many tokens the generator
+ * emitted (C tokens, tags, key=value numbers or identifier lines); tokens/s is that
+ * count divided by the run time.
+ *
+ * run builds any missing corpora in --corpus-dir, then runs every built tool
+ * from --bin-dir against the matching corpus as a child process. It keeps the
+ * best wall time of --repeat runs and the largest peak RSS reported by wait4.
+ * Tool output goes to /dev/null. With --baseline the MB/s of every case is
+ * compared with the stored value, and the exit status is 1 if any case is more
+ * than --threshold percent slower. A baseline file that cannot be read is an
+ * error, and cases without a stored entry are listed as unchecked, so a
+ * missing baseline never passes as "no regressions". --update-baseline stores
+ * the results instead, replacing older entries for the same cases; it is the
+ * only mode in which the file may be missing.
+ */
+
+#define BASELINE_MAX 256
+#define LABEL_MAX 64
+#define PATH_MAX_LEN 1024
+
+/* ---------- Deterministic corpus generation ---------- */
+
+typedef struct {
+    FILE *out;
+    uint64_t bytes;          /* Written so far. */
+    uint64_t tokens;         /* Tokens emitted so far. */
+    uint64_t rng;            /* xorshift64 state. */
+} Generator;
+
+static uint64_t next_random(Generator *g) {
+    g->rng ^= g->rng << 13;
+    g->rng ^= g->rng >> 7;
+    g->rng ^= g->rng << 17;
+    return g->rng;
+}
+
+static unsigned pick(Generator *g, unsigned n) {
+    return (unsigned)(next_random(g) % n);
+}
+
+static void put(Generator *g, const char *s) {
+    size_t n = strlen(s);
+    fwrite(s, 1, n, g->out);
+    g->bytes += n;
+}
+
+static void token(Generator *g, const char *s) {
+    put(g, s);
+    g->tokens++;
+}
+
+static void putf(Generator *g, bool is_token, const char *fmt, unsigned long long v) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), fmt, v);
+    is_token ? token(g, buf) : put(g, buf);
+}
+
+static const char *const c_types[] = { "int", "unsigned", "long", "char", "double", "size_t" };
+static const char *const c_names[] = {
+    "count", "index", "value", "buffer", "length", "node", "next", "result",
+    "total", "offset", "state", "limit", "cursor", "width", "height", "flags"
+};
+static const char *const c_ops[] = {
+    "+", "-", "*", "/", "%", "<<", ">>", "&", "|", "^", "&&", "||",
+    "==", "!=", "<", "<=", ">", ">="
+};
+static const char *const c_assign[] = { "=", "+=", "-=", "*=", "|=", "&=", "<<=" };
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+static void gen_number(Generator *g) {
+    switch (pick(g, 5)) {
+    case 0: putf(g, true, "%llu", next_random(g) % 1000); break;
+    case 1: putf(g, true, "0x%llX", next_random(g) % 0x100000); break;
+    case 2: putf(g, true, "%lluU", next_random(g) % 65536); break;
+    case 3: putf(g, true, "%llu.5e-3", next_random(g) % 100); break;
+    default: putf(g, true, "%lluL", next_random(g) % 100000); break;
+    }
+}
+
+static void gen_operand(Generator *g) {
+    if (pick(g, 3) == 0) {
+        gen_number(g);
+    } else {
+        token(g, c_names[pick(g, COUNT(c_names))]);
+    }
+}
+
+/* One function with a header comment, declarations, a loop and a few expression statements. */
+static void gen_c_function(Generator *g, unsigned long long id) {
+    put(g, "/*\n * Helper ");
+    putf(g, false, "%llu", id);
+    put(g, ": updates the running state.\n */\n");
+    token(g, "static"); put(g, " "); token(g, c_types[pick(g, COUNT(c_types))]);
+    putf(g, true, " fn_%llu", id); token(g, "("); token(g, "int"); put(g, " "); token(g, "n"); token(g, ")");
+    put(g, " "); token(g, "{"); put(g, "\n");
+    for (unsigned i = 0, decls = 1 + pick(g, 3); i < decls; ++i) {
+        put(g, "    "); token(g, c_types[pick(g, COUNT(c_types))]); put(g, " ");
+        token(g, c_names[pick(g, COUNT(c_names))]); put(g, " "); token(g, "="); put(g, " ");
+        gen_number(g); token(g, ";"); put(g, "\n");
+    }
+    put(g, "    "); token(g, "for"); put(g, " "); token(g, "("); token(g, "int"); put(g, " "); token(g, "i");
+    put(g, " "); token(g, "="); put(g, " "); token(g, "0"); token(g, ";"); put(g, " "); token(g, "i");
+    put(g, " "); token(g, "<"); put(g, " "); token(g, "n"); token(g, ";"); put(g, " "); token(g, "++");
+    token(g, "i"); token(g, ")"); put(g, " "); token(g, "{"); put(g, " // walk the input\n");
+    for (unsigned i = 0, stmts = 2 + pick(g, 4); i < stmts; ++i) {
+        put(g, "        "); token(g, c_names[pick(g, COUNT(c_names))]); put(g, " ");
+        token(g, c_assign[pick(g, COUNT(c_assign))]); put(g, " ");
+        gen_operand(g);
+        for (unsigned j = 0, terms = pick(g, 4); j < terms; ++j) {
+            put(g, " "); token(g, c_ops[pick(g, COUNT(c_ops))]); put(g, " "); gen_operand(g);
+        }
+        token(g, ";"); put(g, "\n");
+    }
+    put(g, "    "); token(g, "}"); put(g, "\n");
+    put(g, "    "); token(g, "printf"); token(g, "("); token(g, "\"fn %d: \\\"done\\\"\\n\""); token(g, ",");
+    put(g, " "); token(g, "n"); token(g, ")"); token(g, ";"); put(g, "\n");
+    put(g, "    "); token(g, "return"); put(g, " "); token(g, c_names[pick(g, COUNT(c_names))]);
+    token(g, ";"); put(g, "\n"); token(g, "}"); put(g, "\n\n");
+}
+
+static const char *const html_tags[] = { "div", "span", "p", "a", "li", "td", "section", "em" };
+
+static void gen_html_block(Generator *g, unsigned long long id) {
+    const char *tag = html_tags[pick(g, COUNT(html_tags))];
+    put(g, "<"); put(g, tag); putf(g, false, " class=\"c%llu\">", id % 97); g->tokens++;
+    put(g, "Item ");
+    putf(g, false, "%llu", id);
+    if (pick(g, 3) == 0) {
+        putf(g, false, " <a href=\"/page/%llu\">", next_random(g) % 10000); g->tokens++;
+        put(g, "link"); token(g, "</a>");
+    }
+    if (pick(g, 4) == 0) {
+        token(g, "<br/>");
+    }
+    put(g, "</"); put(g, tag); put(g, ">\n"); g->tokens++;
+    if (pick(g, 16) == 0) {
+        token(g, "<!-- section break -->"); put(g, "\n");
+    }
+}
+
+static void gen_log_line(Generator *g, unsigned long long id) {
+    putf(g, false, "2024-05-%02llu ", 1 + id % 28);
+    putf(g, false, "%02llu:00:00 ", id % 24);
+    putf(g, false, "req=%llu ", id); g->tokens++;
+    putf(g, false, "status=%llu ", 200 + (next_random(g) % 4) * 100); g->tokens++;
+    putf(g, false, "latency=0.%04llu ", next_random(g) % 10000); g->tokens++;
+    putf(g, false, "bytes=0x%llX ", next_random(g) % 0x1000000); g->tokens++;
+    putf(g, false, "ratio=%llu.25e-3\n", next_random(g) % 10); g->tokens++;
+}
+
+static void gen_ident_line(Generator *g, unsigned long long id) {
+    switch (pick(g, 10)) {
+    case 0: putf(g, false, "%llubad\n", id % 10); break;           /* Invalid: leading digit. */
+    case 1: putf(g, false, "bad-name%llu\n", id % 100); break;      /* Invalid: '-'. */
+    default:
+        put(g, c_names[pick(g, COUNT(c_names))]);
+        putf(g, false, "_%llu", id);
+        put(g, pick(g, 2) ? "Value\n" : "x\n");
+        break;
+    }
+    g->tokens++;
+}
+
+/* Parses "1M", "100M", "1G", "64K" or plain bytes. Returns 0 on error. */
+static uint64_t parse_size(const char *s) {
+    char *end;
+    unsigned long long v = strtoull(s, &end, 10);
+    switch (*end) {
+    case 'K': case 'k': v <<= 10; end++; break;
+    case 'M': case 'm': v <<= 20; end++; break;
+    case 'G': case 'g': v <<= 30; end++; break;
+    default: break;
+    }
+    return (*end == '\0') ? v : 0;
+}
+
+static int generate(const char *kind, uint64_t size, const char *path) {
+    void (*emit)(Generator *, unsigned long long);
+    if (strcmp(kind, "c") == 0) emit = gen_c_function;
+    else if (strcmp(kind, "html") == 0) emit = gen_html_block;
+    else if (strcmp(kind, "log") == 0) emit = gen_log_line;
+    else if (strcmp(kind, "ident") == 0) emit = gen_ident_line;
+    else {
+        fprintf(stderr, "Unknown corpus kind '%s' (c, html, log, ident).\n", kind);
+        return 1;
+    }
+
+    Generator g = { fopen(path, "w"), 0, 0, 0x9E3779B97F4A7C15ull ^ (uint64_t)kind[0] };
+    if (g.out == NULL) {
+        perror(path);
+        return 1;
+    }
+    setvbuf(g.out, NULL, _IOFBF, 1 << 20);
+    for (unsigned long long id = 0; g.bytes < size; ++id) {          /* Whole units only, so the last may overshoot. */
+        emit(&g, id);
+    }
+    if (fclose(g.out) != 0) {
+        perror(path);
+        return 1;
+    }
+
+    char meta[PATH_MAX_LEN + 16];
+    snprintf(meta, sizeof(meta), "%s.tokens", path);
+    FILE *fp = fopen(meta, "w");
+    if (fp == NULL || fprintf(fp, "%llu\n", (unsigned long long)g.tokens) < 0 || fclose(fp) != 0) {
+        perror(meta);
+        return 1;
+    }
+    return 0;
+}
+
+/* ---------- Running the tools ---------- */
+
+typedef struct {
+    const char *label;       /* Case name used in reports and the baseline. */
+    const char *tool;        /* Executable in --bin-dir. */
+    const char *corpus;      /* Corpus kind. */
+    bool use_stdin;          /* Feed the corpus on stdin instead of by name. */
+    const char *args[5];     /* Arguments; "{in}" / "{out}" / "{threads}" are substituted. NULL-terminated. */
+} BenchCase;
+
+static const BenchCase cases[] = {
+    { "02a_hello_world",      "practical02a_hello_world",          "c",     true,  { NULL } },
+    { "02b_token_categories", "practical02b_token_categories",     "c",     true,  { NULL } },
+    { "02c_vowel_consonant",  "practical02c_vowel_consonant_count","c",     true,  { NULL } },
+    { "02d_metrics",          "practical02d_file_metrics",         "c",     false, { "{in}", NULL } },
+    { "02d_metrics_flex",     "practical02d_file_metrics",         "c",     false, { "--flex", "{in}", NULL } },
+    { "03a_numbers",          "practical03a_extract_numbers",      "log",   false, { "{in}", NULL } },
+    { "03b_tag_index",        "practical03b_extract_html_tags",    "html",  false, { "--index", "{in}", "{out}", NULL } },
+    { "03c_strip",            "practical03c_strip_comments",       "c",     false, { "{in}", "{out}", NULL } },
+    { "03c_strip_fast",       "practical03c_strip_comments",       "c",     false, { "--fast", "{in}", "{out}", NULL } },
+    { "03c_strip_threads",    "practical03c_strip_comments",       "c",     false, { "--threads", "{threads}", "{in}", "{out}", NULL } },
+    { "04_keywords",          "practical04_keyword_identifier",    "c",     false, { "{in}", NULL } },
+    { "05a_stream",           "practical05a_comment_check",        "c",     false, { "--stream", "{in}", NULL } },
+    { "05b_ident_batch",      "practical05b_identifier_validation","ident", false, { "--batch", "{in}", NULL } },
+    { "06_operators",         "practical06_operator_classifier",   "c",     false, { "--counts", "{in}", NULL } },
+    { "10_ident_parser",      "practical10_identifier",            "ident", false, { "--batch", "{in}", NULL } },
+    { "11_unified",           "practical11_unified_analysis",      "c",     false, { "{in}", NULL } },
+};
+
+static const char *corpus_ext(const char *kind) {
+    return strcmp(kind, "c") == 0 ? "c" : strcmp(kind, "html") == 0 ? "html"
+         : strcmp(kind, "log") == 0 ? "log" : "txt";
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Runs argv once. Returns 0 and fills *secs / *rss_kb, or -1 if the child could not run or failed. */
+static int run_child(char *const argv[], const char *stdin_path, double *secs, long *rss_kb) {
+    double t0 = now_seconds();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (pid == 0) {
+        int in = open(stdin_path ? stdin_path : "/dev/null", O_RDONLY);
+        int null = open("/dev/null", O_WRONLY);
+        if (in < 0 || null < 0) _exit(127);
+        dup2(in, STDIN_FILENO);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        execv(argv[0], argv);
+        _exit(127);
+    }
+    int status;
+    struct rusage ru;
+    if (wait4(pid, &status, 0, &ru) < 0) {
+        perror("wait4");
+        return -1;
+    }
+    *secs = now_seconds() - t0;
+    *rss_kb = ru.ru_maxrss;                                         /* Kilobytes on Linux. */
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -1;
+}
+
+typedef struct {
+    char key[LABEL_MAX];     /* "<label>@<size>" */
+    double mb_per_s;
+} BaselineEntry;
+
+/* Reads path into entries; returns the entry count, or -1 if the file cannot be opened. */
+static long load_baseline(const char *path, BaselineEntry *entries) {
+    FILE *fp = fopen(path, "r");
+    size_t n = 0;
+    if (fp == NULL) {
+        return -1;
+    }
+    while (n < BASELINE_MAX && fscanf(fp, "%63s %lf", entries[n].key, &entries[n].mb_per_s) == 2) {
+        n++;
+    }
+    fclose(fp);
+    return (long)n;
+}
+
+static BaselineEntry *find_entry(BaselineEntry *entries, size_t n, const char *key) {
+    for (size_t i = 0; i < n; ++i) {
+        if (strcmp(entries[i].key, key) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+typedef struct {
+    const char *bin_dir, *corpus_dir, *sizes, *only, *baseline;
+    int repeat;
+    double threshold;        /* Percent. */
+    bool update_baseline;
+} RunOptions;
+
+/* Makes sure <corpus_dir>/<kind>-<size>.<ext> exists; returns its token count. */
+static int ensure_corpus(const RunOptions *opt, const char *kind, const char *size_text, uint64_t size,
+                         char *path, size_t path_len, uint64_t *tokens) {
+    snprintf(path, path_len, "%s/%s-%s.%s", opt->corpus_dir, kind, size_text, corpus_ext(kind));
+    char meta[PATH_MAX_LEN + 16];
+    snprintf(meta, sizeof(meta), "%s.tokens", path);
+    struct stat st;
+    FILE *fp = NULL;
+    if (stat(path, &st) != 0 || (uint64_t)st.st_size < size || (fp = fopen(meta, "r")) == NULL) {
+        fprintf(stderr, "generating %s ...\n", path);
+        if (generate(kind, size, path) != 0 || (fp = fopen(meta, "r")) == NULL) {
+            return -1;
+        }
+    }
+    unsigned long long t = 0;
+    if (fscanf(fp, "%llu", &t) != 1) {
+        t = 0;
+    }
+    fclose(fp);
+    *tokens = t;
+    return 0;
+}
+
+static int run_benchmarks(const RunOptions *opt) {
+    mkdir(opt->corpus_dir, 0777);                                   /* Fine if it already exists. */
+    BaselineEntry baseline[BASELINE_MAX];
+    size_t baseline_count = 0;
+    if (opt->baseline) {
+        long loaded = load_baseline(opt->baseline, baseline);
+        if (loaded < 0 && !opt->update_baseline) {
+            perror(opt->baseline);
+            fprintf(stderr, "No baseline to compare against; store one with --update-baseline "
+                            "(the bench-baseline target) first.\n");
+            return 1;
+        }
+        baseline_count = loaded > 0 ? (size_t)loaded : 0;
+    }
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    char threads[24];
+    snprintf(threads, sizeof(threads), "%ld", online > 0 ? online : 1);
+
+    printf("%-22s %6s %9s %10s %12s %10s  %s\n", "case", "size", "seconds", "MB/s", "tokens/s", "peak RSS", "baseline");
+    int failures = 0, unchecked = 0;
+    char sizes[256];
+    snprintf(sizes, sizeof(sizes), "%s", opt->sizes);
+    for (char *size_text = strtok(sizes, ","); size_text != NULL; size_text = strtok(NULL, ",")) {
+        uint64_t size = parse_size(size_text);
+        if (size == 0) {
+            fprintf(stderr, "Bad size '%s'.\n", size_text);
+            return 1;
+        }
+        for (size_t c = 0; c < COUNT(cases); ++c) {
+            const BenchCase *bc = &cases[c];
+            if (opt->only && strcmp(opt->only, bc->tool) != 0 && strcmp(opt->only, bc->label) != 0) {
+                continue;
+            }
+            char exe[PATH_MAX_LEN];
+            snprintf(exe, sizeof(exe), "%s/%s", opt->bin_dir, bc->tool);
+            if (access(exe, X_OK) != 0) {
+                printf("%-22s %6s %9s\n", bc->label, size_text, "skipped (not built)");
+                continue;
+            }
+            char in[PATH_MAX_LEN], out[PATH_MAX_LEN];
+            uint64_t tokens;
+            if (ensure_corpus(opt, bc->corpus, size_text, size, in, sizeof(in), &tokens) != 0) {
+                return 1;
+            }
+            snprintf(out, sizeof(out), "%s/%s.out", opt->corpus_dir, bc->label);
+
+            char *argv[8];
+            int argc = 0;
+            argv[argc++] = exe;
+            for (int a = 0; bc->args[a] != NULL; ++a) {
+                const char *arg = bc->args[a];
+                argv[argc++] = strcmp(arg, "{in}") == 0 ? in : strcmp(arg, "{out}") == 0 ? out
+                             : strcmp(arg, "{threads}") == 0 ? threads : (char *)arg;
+            }
+            argv[argc] = NULL;
+
+            double best = 0.0;
+            long peak = 0;
+            bool ok = true;
+            for (int r = 0; r < opt->repeat && ok; ++r) {
+                double secs;
+                long rss;
+                remove(out);                                        /* The tag index would otherwise be extended, not rebuilt. */
+                ok = run_child(argv, bc->use_stdin ? in : NULL, &secs, &rss) == 0;
+                if (ok && (r == 0 || secs < best)) best = secs;
+                if (ok && rss > peak) peak = rss;
+            }
+            remove(out);
+            if (!ok) {
+                printf("%-22s %6s %9s\n", bc->label, size_text, "FAILED");
+                failures++;
+                continue;
+            }
+
+            struct stat st;
+            double mb = (stat(in, &st) == 0) ? (double)st.st_size / (1024.0 * 1024.0) : 0.0;
+            double rate = best > 0 ? mb / best : 0.0;
+            char key[LABEL_MAX], verdict[64] = "-";
+            snprintf(key, sizeof(key), "%s@%s", bc->label, size_text);
+            BaselineEntry *base = find_entry(baseline, baseline_count, key);
+            if (opt->update_baseline) {
+                if (base == NULL && baseline_count < BASELINE_MAX) {
+                    base = &baseline[baseline_count++];
+                    snprintf(base->key, sizeof(base->key), "%s", key);
+                }
+                if (base != NULL) base->mb_per_s = rate;
+                snprintf(verdict, sizeof(verdict), "stored");
+            } else if (base != NULL && base->mb_per_s > 0) {
+                double change = (rate / base->mb_per_s - 1.0) * 100.0;
+                bool regressed = change < -opt->threshold;
+                snprintf(verdict, sizeof(verdict), "%+.1f%%%s", change, regressed ? " REGRESSED" : "");
+                failures += regressed;
+            } else if (opt->baseline) {
+                snprintf(verdict, sizeof(verdict), "no baseline");
+                unchecked++;
+            }
+            printf("%-22s %6s %9.3f %10.1f %12.0f %7ld KB  %s\n", bc->label, size_text, best, rate,
+                   best > 0 ? (double)tokens / best : 0.0, peak, verdict);
+            fflush(stdout);
+        }
+    }
+
+    if (opt->update_baseline && opt->baseline) {
+        FILE *fp = fopen(opt->baseline, "w");
+        if (fp == NULL) {
+            perror(opt->baseline);
+            return 1;
+        }
+        for (size_t i = 0; i < baseline_count; ++i) {
+            fprintf(fp, "%s %.3f\n", baseline[i].key, baseline[i].mb_per_s);
+        }
+        if (fclose(fp) != 0) {
+            perror(opt->baseline);
+            return 1;
+        }
+        printf("baseline written to %s\n", opt->baseline);
+    }
+    if (unchecked > 0) {
+        fprintf(stderr, "warning: %d case(s) have no entry in %s and were not checked; "
+                        "refresh it with --update-baseline.\n", unchecked, opt->baseline);
+    }
+    if (failures > 0) {
+        fprintf(stderr, "%d case(s) failed or regressed by more than %.1f%%.\n", failures, opt->threshold);
+        return 1;
+    }
+    return 0;
+}
+
+static int usage(const char *prog) {
+    fprintf(stderr, "Usage: %s generate <c|html|log|ident> <size> <file>\n"
+                    "       %s run [--bin-dir DIR] [--corpus-dir DIR] [--sizes 1M,100M,1G] [--repeat N]\n"
+                    "              [--only TOOL] [--threshold PCT] [--baseline FILE] [--update-baseline]\n",
+            prog, prog);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 5 && strcmp(argv[1], "generate") == 0) {
+        uint64_t size = parse_size(argv[3]);
+        if (size == 0) {
+            fprintf(stderr, "Bad size '%s'.\n", argv[3]);
+            return 1;
+        }
+        return generate(argv[2], size, argv[4]);
+    }
+    if (argc < 2 || strcmp(argv[1], "run") != 0) {
+        return usage(argv[0]);
+    }
+
+    RunOptions opt = { ".", "corpus", "1M", NULL, NULL, 3, 10.0, false };
+    for (int i = 2; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--update-baseline") == 0) opt.update_baseline = true;
+        else if (has_value && strcmp(argv[i], "--bin-dir") == 0) opt.bin_dir = argv[++i];
+        else if (has_value && strcmp(argv[i], "--corpus-dir") == 0) opt.corpus_dir = argv[++i];
+        else if (has_value && strcmp(argv[i], "--sizes") == 0) opt.sizes = argv[++i];
+        else if (has_value && strcmp(argv[i], "--only") == 0) opt.only = argv[++i];
+        else if (has_value && strcmp(argv[i], "--baseline") == 0) opt.baseline = argv[++i];
+        else if (has_value && strcmp(argv[i], "--repeat") == 0) opt.repeat = atoi(argv[++i]);
+        else if (has_value && strcmp(argv[i], "--threshold") == 0) opt.threshold = strtod(argv[++i], NULL);
+        else return usage(argv[0]);
+    }
+    if (opt.repeat < 1 || opt.threshold < 0) {
+        return usage(argv[0]);
+    }
+    if (opt.update_baseline && opt.baseline == NULL) {
+        fprintf(stderr, "--update-baseline needs --baseline FILE.\n");
+        return 1;
+    }
+    return run_benchmarks(&opt);
+}
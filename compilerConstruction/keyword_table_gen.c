@@ -0,0 +1,111 @@
+#include <stdio.h>   /* fopen / fprintf */
+#include <string.h>  /* strlen / strcmp */
+
+/*
+ * Build step for lexical_engine.c: finds a perfect hash over lex_keywords.def
+ * and writes the slot table as a C initialiser, so the engine's keyword lookup
+ * needs no start-up work and cannot drift from the word list.
+ *
+ * Usage:
+ *   ./keyword_table_gen lex_keyword_table.h
+ *
+ * The hash is (len_mul * length + ends_mul * (first + last char)) mod slots.
+ * The smallest power-of-two table with a collision-free multiplier pair wins;
+ * the generator fails if none exists, or a word is listed twice.
+ */
+
+static const char *const keywords[] = {
+#define LEX_KEYWORD(s) s,
+#include "lex_keywords.def"
+#undef LEX_KEYWORD
+};
+#define KEYWORD_COUNT (sizeof(keywords) / sizeof(keywords[0]))
+#define MAX_SLOTS 1024
+#define MAX_MUL 31
+
+static unsigned hash(const char *word, size_t len, unsigned len_mul, unsigned ends_mul, unsigned slots) {
+    return (unsigned)(len_mul * len + ends_mul * ((unsigned char)word[0] + (unsigned char)word[len - 1])) % slots;
+}
+
+/* Fills slot_of[] and returns 1 when the parameters place every word in its own slot. */
+static int try_hash(unsigned len_mul, unsigned ends_mul, unsigned slots, int slot_of[MAX_SLOTS]) {
+    for (unsigned i = 0; i < slots; ++i) {
+        slot_of[i] = -1;
+    }
+    for (size_t k = 0; k < KEYWORD_COUNT; ++k) {
+        unsigned h = hash(keywords[k], strlen(keywords[k]), len_mul, ends_mul, slots);
+        if (slot_of[h] >= 0) {
+            return 0;
+        }
+        slot_of[h] = (int)k;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <output-header>\n", argv[0]);
+        return 1;
+    }
+    size_t min_len = (size_t)-1, max_len = 0;
+    for (size_t k = 0; k < KEYWORD_COUNT; ++k) {
+        size_t len = strlen(keywords[k]);
+        if (len == 0 || len > 255) {                                    /* KeywordSlot caches the length in a byte. */
+            fprintf(stderr, "lex_keywords.def: bad keyword \"%s\"\n", keywords[k]);
+            return 1;
+        }
+        for (size_t j = 0; j < k; ++j) {
+            if (strcmp(keywords[j], keywords[k]) == 0) {
+                fprintf(stderr, "lex_keywords.def: \"%s\" is listed twice\n", keywords[k]);
+                return 1;
+            }
+        }
+        min_len = len < min_len ? len : min_len;
+        max_len = len > max_len ? len : max_len;
+    }
+
+    static int slot_of[MAX_SLOTS];
+    unsigned slots = 0, len_mul = 0, ends_mul = 0;
+    for (unsigned s = 16; s <= MAX_SLOTS && slots == 0; s *= 2) {
+        if (s < KEYWORD_COUNT) {
+            continue;
+        }
+        for (unsigned a = 1; a <= MAX_MUL && slots == 0; ++a) {
+            for (unsigned b = 1; b <= MAX_MUL; ++b) {
+                if (try_hash(a, b, s, slot_of)) {
+                    slots = s, len_mul = a, ends_mul = b;
+                    break;
+                }
+            }
+        }
+    }
+    if (slots == 0) {
+        fprintf(stderr, "no perfect hash for %zu keywords up to %d slots\n", (size_t)KEYWORD_COUNT, MAX_SLOTS);
+        return 1;
+    }
+
+    FILE *out = fopen(argv[1], "w");
+    if (out == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    fprintf(out, "/* Generated by keyword_table_gen from lex_keywords.def; do not edit. */\n");
+    fprintf(out, "#define KEYWORD_SLOTS %u\n", slots);
+    fprintf(out, "#define KEYWORD_MIN_LEN %zu\n", min_len);
+    fprintf(out, "#define KEYWORD_MAX_LEN %zu\n", max_len);
+    fprintf(out, "#define KEYWORD_HASH_LEN_MUL %uu\n", len_mul);
+    fprintf(out, "#define KEYWORD_HASH_ENDS_MUL %uu\n\n", ends_mul);
+    fprintf(out, "static const KeywordSlot keyword_slots[KEYWORD_SLOTS] = {\n");
+    for (unsigned i = 0; i < slots; ++i) {
+        if (slot_of[i] >= 0) {
+            const char *word = keywords[slot_of[i]];
+            fprintf(out, "    [%u] = { \"%s\", %zu },\n", i, word, strlen(word));
+        }
+    }
+    fprintf(out, "};\n");
+    if (fclose(out) != 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    return 0;
+}
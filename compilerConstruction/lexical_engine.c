@@ -0,0 +1,406 @@
+#define _POSIX_C_SOURCE 200809L /* Expose posix_madvise. */
+
+#include "lexical_engine.h"
+
+#include <stdio.h>     /* perror / fprintf */
+#include <stdlib.h>    /* realloc / free for inputs that cannot be mapped */
+#include <string.h>    /* memchr / memcmp / memset / strlen */
+#include <errno.h>     /* EINTR from read() */
+#include <fcntl.h>     /* open() */
+#include <unistd.h>    /* read() / close() */
+#include <pthread.h>   /* pthread_once for the class tables */
+#include <sys/mman.h>  /* mmap / munmap */
+#include <sys/stat.h>  /* fstat */
+#if defined(__SSE2__)
+#include <emmintrin.h> /* 16-byte word/line kernel. */
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h> /* 32-byte word/line kernel. */
+#endif
+
+static const char *const kind_names[LEX_KIND_COUNT] = {
+    "Whitespace", "Comment", "Keyword", "Identifier", "Number",
+    "String", "Operator", "Punctuator", "Unknown"
+};
+
+static const char *const family_names[LEX_OP_FAMILY_COUNT] = {
+    "Other", "Arithmetic", "Relational", "Logical", "Assignment", "Bitwise"
+};
+
+const char *lex_kind_name(LexKind kind) {
+    return kind_names[kind];
+}
+
+const char *lex_family_name(LexOperatorFamily family) {
+    return family_names[family];
+}
+
+/* ---------- Keywords ---------- */
+
+const char *const lex_keywords[] = {
+#define LEX_KEYWORD(s) s,
+#include "lex_keywords.def"
+#undef LEX_KEYWORD
+};
+const size_t lex_keyword_count = sizeof(lex_keywords) / sizeof(lex_keywords[0]);
+
+/*
+ * Perfect hash over lex_keywords.def. keyword_table_gen picks the multipliers
+ * and writes the slots as a constant initialiser at build time, so nothing is
+ * built or checked at run time; one hash, one length check and one memcmp
+ * decide any token.
+ */
+typedef struct {
+    const char *text;          /* Keyword spelling, NULL for an empty slot. */
+    unsigned char len;         /* Cached strlen(text). */
+} KeywordSlot;
+
+#include "lex_keyword_table.h"
+
+static unsigned keyword_hash(const char *text, size_t len) {
+    return (unsigned)(KEYWORD_HASH_LEN_MUL * len
+                      + KEYWORD_HASH_ENDS_MUL * ((unsigned char)text[0] + (unsigned char)text[len - 1])) % KEYWORD_SLOTS;
+}
+
+bool lex_is_keyword(const char *text, size_t len) {
+    if (len < KEYWORD_MIN_LEN || len > KEYWORD_MAX_LEN) {        /* Cheap reject before hashing. */
+        return false;
+    }
+    const KeywordSlot *slot = &keyword_slots[keyword_hash(text, len)];
+    return slot->len == len && memcmp(slot->text, text, len) == 0; /* Empty slots have len 0 and never match. */
+}
+
+/* ---------- Punctuators, longest first, with practical06's families. ---------- */
+
+const LexPunctuator lex_punctuators[] = {
+    { "<<=", LEX_OP_ASSIGNMENT }, { ">>=", LEX_OP_ASSIGNMENT }, { "...", LEX_NOT_OPERATOR },
+    { "->", LEX_OP_OTHER },       { "++", LEX_OP_OTHER },       { "--", LEX_OP_OTHER },
+    { "<<", LEX_OP_BITWISE },     { ">>", LEX_OP_BITWISE },     { "<=", LEX_OP_RELATIONAL },
+    { ">=", LEX_OP_RELATIONAL },  { "==", LEX_OP_RELATIONAL },  { "!=", LEX_OP_RELATIONAL },
+    { "&&", LEX_OP_LOGICAL },     { "||", LEX_OP_LOGICAL },     { "*=", LEX_OP_ASSIGNMENT },
+    { "/=", LEX_OP_ASSIGNMENT },  { "%=", LEX_OP_ASSIGNMENT },  { "+=", LEX_OP_ASSIGNMENT },
+    { "-=", LEX_OP_ASSIGNMENT },  { "&=", LEX_OP_ASSIGNMENT },  { "^=", LEX_OP_ASSIGNMENT },
+    { "|=", LEX_OP_ASSIGNMENT },  { "##", LEX_NOT_OPERATOR },   { "[", LEX_NOT_OPERATOR },
+    { "]", LEX_NOT_OPERATOR },    { "(", LEX_NOT_OPERATOR },    { ")", LEX_NOT_OPERATOR },
+    { "{", LEX_NOT_OPERATOR },    { "}", LEX_NOT_OPERATOR },    { ".", LEX_NOT_OPERATOR },
+    { "&", LEX_OP_BITWISE },      { "*", LEX_OP_ARITHMETIC },   { "+", LEX_OP_ARITHMETIC },
+    { "-", LEX_OP_ARITHMETIC },   { "~", LEX_OP_BITWISE },      { "!", LEX_OP_LOGICAL },
+    { "/", LEX_OP_ARITHMETIC },   { "%", LEX_OP_ARITHMETIC },   { "<", LEX_OP_RELATIONAL },
+    { ">", LEX_OP_RELATIONAL },   { "^", LEX_OP_BITWISE },      { "|", LEX_OP_BITWISE },
+    { "?", LEX_NOT_OPERATOR },    { ":", LEX_NOT_OPERATOR },    { ";", LEX_NOT_OPERATOR },
+    { "=", LEX_OP_ASSIGNMENT },   { ",", LEX_NOT_OPERATOR },    { "#", LEX_NOT_OPERATOR }
+};
+
+const size_t lex_punctuator_count = sizeof(lex_punctuators) / sizeof(lex_punctuators[0]);
+#define PUNCT_PER_BYTE 5        /* Most punctuators sharing a first byte ('<' and '-' have four), plus a 0 terminator. */
+
+/* For each first byte, 1-based indices into punctuators[], still longest first. Built with the classes. */
+static unsigned char punct_bucket[256][PUNCT_PER_BYTE];
+
+/* Length of the longest punctuator at p (0 if none); *family receives its family. */
+static size_t match_punctuator(const unsigned char *p, const unsigned char *end, int *family) {
+    size_t avail = (size_t)(end - p);
+    for (const unsigned char *b = punct_bucket[*p]; *b != 0; ++b) {
+        const char *t = lex_punctuators[*b - 1].text;
+        size_t n = t[1] == '\0' ? 1 : (t[2] == '\0' ? 2 : 3);
+        if (n <= avail && memcmp(p, t, n) == 0) {
+            *family = lex_punctuators[*b - 1].family;
+            return n;
+        }
+    }
+    return 0;
+}
+
+/* ---------- Character classes. ---------- */
+
+enum { CLS_WORD = 1, CLS_DIGIT = 2, CLS_IDENT_START = 4, CLS_SPACE = 8 };
+static unsigned char char_class[256];
+static pthread_once_t classes_once = PTHREAD_ONCE_INIT; /* Front ends may run the engine on several threads. */
+
+static void build_classes(void) {
+    for (int c = 0; c < 256; ++c) {
+        bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        bool digit = c >= '0' && c <= '9';
+        char_class[c] = (unsigned char)((lex_is_word_byte((unsigned char)c) ? CLS_WORD : 0)
+                                        | (digit ? CLS_DIGIT : 0)
+                                        | ((alpha || c == '_') ? CLS_IDENT_START : 0)
+                                        | ((c == ' ' || c == '\t' || c == '\n' || c == '\r'
+                                            || c == '\v' || c == '\f') ? CLS_SPACE : 0));
+    }
+    for (size_t i = 0; i < lex_punctuator_count; ++i) {
+        unsigned char *b = punct_bucket[(unsigned char)lex_punctuators[i].text[0]];
+        while (*b != 0) b++;
+        *b = (unsigned char)(i + 1);
+    }
+}
+
+/* ---------- Words and lines (practical02d's kernel). ---------- */
+
+#if defined(__SSE2__)
+static inline __m128i in_range_16(__m128i x, char lo, char hi) { /* Unsigned lo <= x <= hi, per byte. */
+    __m128i t = _mm_sub_epi8(x, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8((char)(hi - lo))), t);
+}
+#endif
+#if defined(__AVX2__)
+static inline __m256i in_range_32(__m256i x, char lo, char hi) {
+    __m256i t = _mm256_sub_epi8(x, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8((char)(hi - lo))), t);
+}
+#endif
+
+/*
+ * A word starts at every word byte whose predecessor is not one; the
+ * predecessor bit is carried across vector blocks, into the scalar tail and
+ * through wc->in_word into the next call, so a run is counted once.
+ */
+void lex_count_words(const unsigned char *p, size_t n, LexWordCount *wc) {
+    unsigned carry = wc->in_word;                                 /* 1 when the previous byte was a word byte. */
+    size_t i = 0;
+#if defined(__AVX2__)
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20)); /* Fold A-Z onto a-z. */
+        __m256i word = _mm256_or_si256(_mm256_or_si256(in_range_32(lower, 'a', 'z'), in_range_32(v, '0', '9')),
+                                       _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        unsigned wm = (unsigned)_mm256_movemask_epi8(word);
+        unsigned nm = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+        wc->words += (uint64_t)__builtin_popcount(wm & ~((wm << 1) | carry)); /* Word bytes whose left neighbour is not one. */
+        wc->lines += (uint64_t)__builtin_popcount(nm);
+        carry = wm >> 31;
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i word = _mm_or_si128(_mm_or_si128(in_range_16(lower, 'a', 'z'), in_range_16(v, '0', '9')),
+                                    _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+        unsigned wm = (unsigned)_mm_movemask_epi8(word);
+        unsigned nm = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+        wc->words += (uint64_t)__builtin_popcount(wm & ~((wm << 1) | carry) & 0xFFFFu);
+        wc->lines += (uint64_t)__builtin_popcount(nm);
+        carry = (wm >> 15) & 1u;
+    }
+#endif
+    for (; i < n; ++i) {                                          /* Scalar tail (or everything without SIMD). */
+        unsigned w = lex_is_word_byte(p[i]);
+        wc->words += w & ~carry;
+        wc->lines += (p[i] == '\n');
+        carry = w;
+    }
+    wc->in_word = carry != 0;
+}
+
+/* ---------- Metrics, computed block by block just ahead of the lexer. ---------- */
+
+#define METRICS_BLOCK (64 * 1024)
+
+typedef struct {
+    size_t done;                /* Bytes already counted. */
+    LexWordCount counts;        /* Running totals and the word carry. */
+} MetricsCursor;
+
+static void metrics_block(const unsigned char *data, size_t len, MetricsCursor *mc) {
+    size_t n = (len - mc->done < METRICS_BLOCK) ? len - mc->done : METRICS_BLOCK;
+    lex_count_words(data + mc->done, n, &mc->counts);
+    mc->done += n;
+}
+
+/* ---------- The lexer. ---------- */
+
+static void dispatch(const LexToken *tok, const LexSubscriber *subs, size_t sub_count) {
+    for (size_t i = 0; i < sub_count; ++i) {
+        if (subs[i].kinds & LEX_KIND_BIT(tok->kind)) {
+            subs[i].on_token(tok, subs[i].user);
+        }
+    }
+}
+
+void lex_engine_run(const unsigned char *data, size_t len,
+                    const LexSubscriber *subs, size_t sub_count, LexSummary *summary) {
+    pthread_once(&classes_once, build_classes);
+    memset(summary, 0, sizeof(*summary));
+    summary->chars = len;
+
+    uint32_t wanted = 0;                                          /* Kinds someone subscribed to. */
+    for (size_t i = 0; i < sub_count; ++i) {
+        wanted |= subs[i].kinds;
+    }
+
+    MetricsCursor mc = { 0, { 0, 0, false } };
+    const unsigned char *p = data, *end = data + len;
+    uint64_t line = 1;                                            /* Line of p. */
+    const unsigned char *line_start = data;                       /* First byte of that line. */
+
+    while (p < end) {
+        if ((size_t)(p - data) >= mc.done) {                      /* Keep the metrics block just ahead of us. */
+            metrics_block(data, len, &mc);
+        }
+
+        LexToken tok;
+        tok.family = LEX_OP_OTHER;
+        tok.comment_lines = 0;
+        const unsigned char *q = p + 1;                           /* End of the token being built. */
+        uint64_t newlines = 0;                                    /* Newlines inside the token. */
+        const unsigned char *last_nl = NULL;
+        unsigned char c = *p;
+        unsigned cls = char_class[c];
+
+        if (cls & CLS_SPACE) {
+            if (c == '\n') { newlines++; last_nl = p; }
+            while (q < end && (char_class[*q] & CLS_SPACE)) {
+                if (*q == '\n') { newlines++; last_nl = q; }
+                q++;
+            }
+            tok.kind = LEX_SPACE;
+        } else if (c == '/' && q < end && *q == '/') {             /* Line comment stops before the newline. */
+            const unsigned char *nl = memchr(q, '\n', (size_t)(end - q));
+            q = nl ? nl : end;
+            tok.kind = LEX_COMMENT;
+            tok.comment_lines = 1;
+        } else if (c == '/' && q < end && *q == '*') {             /* Block comment through the closing star-slash. */
+            q++;
+            while (q < end && !(*q == '/' && q[-1] == '*' && q - p >= 3)) {
+                if (*q == '\n') { newlines++; last_nl = q; }
+                q++;
+            }
+            if (q < end) q++;
+            tok.kind = LEX_COMMENT;
+            tok.comment_lines = 1 + newlines;
+        } else if (cls & CLS_IDENT_START) {
+            while (q < end && (char_class[*q] & CLS_WORD)) q++;
+            tok.kind = lex_is_keyword((const char *)p, (size_t)(q - p)) ? LEX_KEYWORD : LEX_IDENTIFIER;
+        } else if ((cls & CLS_DIGIT) || (c == '.' && q < end && (char_class[*q] & CLS_DIGIT))) {
+            while (q < end) {                                     /* pp-number */
+                unsigned char d = *q, e = q[-1];
+                if ((d == '+' || d == '-') && (e == 'e' || e == 'E' || e == 'p' || e == 'P')) q++;
+                else if ((char_class[d] & CLS_WORD) || d == '.') q++;
+                else break;
+            }
+            tok.kind = LEX_NUMBER;
+        } else if (c == '"' || c == '\'') {                        /* Through the closing quote, as in practical03c. */
+            while (q < end && *q != c) {
+                if (*q == '\\' && q + 1 < end) q++;                /* The escaped byte may be a newline. */
+                if (*q == '\n') { newlines++; last_nl = q; }
+                q++;
+            }
+            if (q < end) q++;
+            tok.kind = LEX_STRING;
+        } else {
+            int family;
+            size_t n = match_punctuator(p, end, &family);
+            if (n > 0) {
+                q = p + n;
+                tok.kind = (family == LEX_NOT_OPERATOR) ? LEX_PUNCTUATOR : LEX_OPERATOR;
+                if (family != LEX_NOT_OPERATOR) {
+                    tok.family = (LexOperatorFamily)family;
+                    summary->operators[family]++;
+                }
+            } else {
+                tok.kind = LEX_UNKNOWN;
+            }
+        }
+
+        summary->tokens[tok.kind]++;
+        summary->comment_lines += tok.comment_lines;
+        if (wanted & LEX_KIND_BIT(tok.kind)) {                    /* Build the token only if someone listens. */
+            tok.text = (const char *)p;
+            tok.len = (size_t)(q - p);
+            tok.offset = (uint64_t)(p - data);
+            tok.line = line;
+            tok.col = (uint64_t)(p - line_start) + 1;
+            dispatch(&tok, subs, sub_count);
+        }
+        if (newlines > 0) {
+            line += newlines;
+            line_start = last_nl + 1;
+        }
+        p = q;
+    }
+    while (mc.done < len) {                                       /* One block per token start lags behind long tokens; count the rest. */
+        metrics_block(data, len, &mc);
+    }
+    summary->lines = mc.counts.lines;
+    summary->words = mc.counts.words;
+}
+
+/* Reads all of fd into a malloc'd buffer. Returns 0, or -1 with errno set. */
+static int read_all(int fd, unsigned char **data, size_t *len) {
+    size_t cap = 1 << 20, n = 0;
+    unsigned char *buf = malloc(cap);
+    if (buf == NULL) {
+        return -1;
+    }
+    for (;;) {
+        if (n == cap) {
+            unsigned char *bigger = realloc(buf, cap * 2);
+            if (bigger == NULL) {
+                free(buf);
+                return -1;
+            }
+            buf = bigger;
+            cap *= 2;
+        }
+        ssize_t r = read(fd, buf + n, cap - n);
+        if (r == 0) {
+            break;
+        }
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            free(buf);
+            return -1;
+        }
+        n += (size_t)r;
+    }
+    *data = buf;
+    *len = n;
+    return 0;
+}
+
+int lex_engine_run_fd(int fd, const char *name, const LexSubscriber *subs, size_t sub_count, LexSummary *summary) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror(name);
+        return -1;
+    }
+    if (!S_ISREG(st.st_mode)) {                                   /* Pipes and terminals cannot be mapped. */
+        unsigned char *data;
+        size_t len;
+        if (read_all(fd, &data, &len) != 0) {
+            perror(name);
+            return -1;
+        }
+        lex_engine_run(data, len, subs, sub_count, summary);
+        free(data);
+        return 0;
+    }
+    size_t len = (size_t)st.st_size;
+    void *m = NULL;
+    if (len > 0) {
+        m = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) {
+            perror(name);
+            return -1;
+        }
+        posix_madvise(m, len, POSIX_MADV_SEQUENTIAL);
+    }
+    lex_engine_run(m, len, subs, sub_count, summary);
+    if (m) {
+        munmap(m, len);
+    }
+    return 0;
+}
+
+int lex_engine_run_file(const char *path, const LexSubscriber *subs, size_t sub_count, LexSummary *summary) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    int status = lex_engine_run_fd(fd, path, subs, sub_count, summary);
+    close(fd);
+    return status;
+}
@@ -0,0 +1,137 @@
+#ifndef LEXICAL_ENGINE_H
+#define LEXICAL_ENGINE_H
+
+#include <stddef.h>  /* size_t */
+#include <stdint.h>  /* uint64_t counters */
+#include <stdbool.h> /* bool */
+
+/*
+ * Shared single-pass lexer core. One walk over the input produces a single
+ * token stream (whitespace, comments, keywords, identifiers, numbers, literals,
+ * operators by family, other punctuators) plus line/word/character metrics.
+ * Front ends register subscribers for the token kinds they care about, so a
+ * combined analysis costs one pass instead of one pass per tool.
+ *
+ * practical04 (tokens, symbols) and practical06 (operators) are front ends over
+ * this engine, and practical02d counts words and lines with lex_count_words
+ * ([A-Za-z0-9_]+ runs over the raw bytes are words).
+ *
+ * Comments and string/character literals follow practical03c's state machine
+ * exactly, so stripping the comment tokens gives practical03c's output and the
+ * comment line count matches it: a literal ends only at its closing quote (a
+ * backslash escapes the next byte, newline included), and an unterminated one
+ * runs to the end of the file. The engine may be run on several threads at once.
+ *
+ * The keyword hash slots (lex_keyword_table.h) are generated from
+ * lex_keywords.def at build time; outside CMake, run
+ *   cc keyword_table_gen.c -o keyword_table_gen && ./keyword_table_gen lex_keyword_table.h
+ * in this directory before compiling lexical_engine.c.
+ */
+
+typedef enum {
+    LEX_SPACE,        /* Whitespace run, newlines included. */
+    LEX_COMMENT,      /* Line or block comment, delimiters included. */
+    LEX_KEYWORD,      /* C11 keyword (or "main", as in practical04). */
+    LEX_IDENTIFIER,
+    LEX_NUMBER,       /* pp-number: 42, 0x1F, 1.5e+3f ... */
+    LEX_STRING,       /* String or character literal, quotes included. */
+    LEX_OPERATOR,     /* Operator; see family. */
+    LEX_PUNCTUATOR,   /* Punctuator that is not an operator: ( ) ; , ... */
+    LEX_UNKNOWN,      /* Any other byte. */
+    LEX_KIND_COUNT
+} LexKind;
+
+typedef enum {
+    LEX_OP_OTHER,     /* ++, --, -> */
+    LEX_OP_ARITHMETIC,
+    LEX_OP_RELATIONAL,
+    LEX_OP_LOGICAL,
+    LEX_OP_ASSIGNMENT,
+    LEX_OP_BITWISE,
+    LEX_OP_FAMILY_COUNT
+} LexOperatorFamily;
+
+typedef struct {
+    LexKind kind;
+    LexOperatorFamily family;  /* Meaningful for LEX_OPERATOR only. */
+    const char *text;          /* Points into the caller's buffer; not NUL-terminated. */
+    size_t len;
+    uint64_t offset;           /* Byte offset of the first byte. */
+    uint64_t line, col;        /* 1-based position of the first byte. */
+    uint64_t comment_lines;    /* LEX_COMMENT: lines it counts for (1 + newlines inside). */
+} LexToken;
+
+typedef void (*LexCallback)(const LexToken *tok, void *user);
+
+#define LEX_KIND_BIT(kind) (1u << (kind))
+#define LEX_ALL_KINDS (LEX_KIND_BIT(LEX_KIND_COUNT) - 1u)
+
+typedef struct {
+    uint32_t kinds;            /* LEX_KIND_BIT mask of the kinds to deliver. */
+    LexCallback on_token;
+    void *user;                /* Passed back to on_token untouched. */
+} LexSubscriber;
+
+typedef struct {
+    uint64_t lines;                           /* '\n' bytes. */
+    uint64_t words;                           /* [A-Za-z0-9_]+ runs over the raw bytes. */
+    uint64_t chars;                           /* Bytes. */
+    uint64_t comment_lines;                   /* Lines touched by comments, counted as practical03c does. */
+    uint64_t tokens[LEX_KIND_COUNT];          /* Tokens per kind. */
+    uint64_t operators[LEX_OP_FAMILY_COUNT];  /* Operators per family. */
+} LexSummary;
+
+/* ---------- Shared tables ---------- */
+
+/* The C11 keywords plus "main" (lex_keywords.def), which the practicals have always reported as reserved. */
+extern const char *const lex_keywords[];
+extern const size_t lex_keyword_count;
+
+/* True when text[0..len) is one of lex_keywords (one hash, one memcmp). */
+bool lex_is_keyword(const char *text, size_t len);
+
+#define LEX_NOT_OPERATOR (-1)
+
+/* Punctuators, longest first; the operators carry their practical06 family. */
+typedef struct {
+    const char *text;
+    int family;                /* LexOperatorFamily, or LEX_NOT_OPERATOR. */
+} LexPunctuator;
+
+extern const LexPunctuator lex_punctuators[];
+extern const size_t lex_punctuator_count;
+
+/* [A-Za-z0-9_], the word bytes of practical02d. */
+static inline bool lex_is_word_byte(unsigned char c) {
+    return (unsigned char)((c | 0x20) - 'a') < 26 || (unsigned char)(c - '0') < 10 || c == '_';
+}
+
+typedef struct {
+    uint64_t lines;            /* '\n' bytes. */
+    uint64_t words;            /* Word starts. */
+    bool in_word;              /* The last byte counted was a word byte. */
+} LexWordCount;
+
+/* Adds the lines and word starts of p[0..n) to wc; a word continued from the previous call is not counted again. */
+void lex_count_words(const unsigned char *p, size_t n, LexWordCount *wc);
+
+/* ---------- Engine ---------- */
+
+/* Lexes data[0..len) once, feeding subscribers in order and filling summary. */
+void lex_engine_run(const unsigned char *data, size_t len,
+                    const LexSubscriber *subs, size_t sub_count, LexSummary *summary);
+
+/*
+ * Runs the engine over an open descriptor: a regular file is mapped, anything
+ * else (a pipe, a terminal) is read into memory first. name labels errors.
+ * Returns 0, or -1 after printing an error.
+ */
+int lex_engine_run_fd(int fd, const char *name, const LexSubscriber *subs, size_t sub_count, LexSummary *summary);
+
+/* Opens path and runs lex_engine_run_fd over it. */
+int lex_engine_run_file(const char *path, const LexSubscriber *subs, size_t sub_count, LexSummary *summary);
+
+const char *lex_kind_name(LexKind kind);
+const char *lex_family_name(LexOperatorFamily family);
+
+#endif /* LEXICAL_ENGINE_H */
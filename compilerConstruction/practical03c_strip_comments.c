@@ -1,15 +1,51 @@
+#define _POSIX_C_SOURCE 200809L /* Expose clock_gettime and posix_madvise. */
+
 #include <stdio.h>    /* FILE, printf, fgetc, fputc, perror live here. */
 #include <stdlib.h>   /* EXIT_SUCCESS / EXIT_FAILURE macros. */
 #include <stdbool.h>  /* bool type used for escape tracking. */
+#include <string.h>   /* memchr, strcmp for the fast path and option parsing. */
+#include <time.h>     /* clock_gettime for the throughput comparison. */
+#include <fcntl.h>    /* open() for the memory-mapped input. */
+#include <unistd.h>   /* close(). */
+#include <sys/mman.h> /* mmap / munmap / posix_madvise. */
+#include <sys/stat.h> /* fstat to learn the input size. */
+#include <pthread.h>  /* Worker threads for the parallel mode. */
+#include <stdatomic.h>/* Lock-free chunk counter shared by the workers. */
+#if defined(__SSE2__)
+#include <emmintrin.h> /* SSE2 intrinsics for the 16-byte scanning kernel. */
+#endif
+#include "scanner_instrumentation.h" /* SI_* hooks; empty unless built with -DSCANNER_INSTRUMENT. */
+
+#define MAX_THREADS 256               /* Bounds the thread handle array on the stack. */
 
 /*
  * This program counts C/C++ style comments in an input file and writes the
  * source code without comments to a second file.
  *
  * Usage:
- *   ./a.out input.c output.c
+ *   ./a.out [--fast | --threads N | --bench [--threads N]] input.c output.c
+ *
+ * Build with -pthread.
  *
  * The comment counter treats every line touched by a comment as a comment line.
+ *
+ * Without options the classic byte-at-a-time state machine is used. --fast maps
+ * the input into memory and lets a vectorised search jump straight to the next
+ * byte that can change the scanner state, copying each plain run with a single
+ * bulk write. --threads N splits the mapped input into chunks and strips them on
+ * N threads (at most MAX_THREADS); --threads 1 is the same as --fast. --bench
+ * runs all paths, checks that they agree byte for byte and prints their
+ * throughput.
+ *
+ * The parallel path reads each chunk once. A chunk whose entry state is not yet
+ * known is stripped as if it started in normal code, which is almost always
+ * right, while the other entry states are only tracked until they fall in step
+ * with it; a wrong guess re-strips just that prefix. Chunks are written in file
+ * order, so the output may be a pipe or terminal.
+ *
+ * Built with -DSCANNER_INSTRUMENT, every path also records bytes and runs per
+ * state, the transition histogram and I/O versus scan time, and writes them as
+ * JSON at exit (see scanner_instrumentation.h).
  */
 
 typedef enum {
@@ -22,66 +58,71 @@ typedef enum {
     STATE_CHAR_LITERAL       /* Inside 'c', care about escapes. */
 } ScannerState;
 
-int main(int argc, char **argv) {
-    if (argc != 3) {                                                  /* Expect executable plus input and output path. */
-        fprintf(stderr, "Usage: %s <input.c> <output.c>\n", argv[0]); /* Remind user about correct syntax. */
-        return EXIT_FAILURE;                                          /* Non-zero exit signals incorrect usage. */
-    }
+static const char *const state_names[] = {                          /* Indexed by ScannerState, for the instrumentation. */
+    "normal", "after_slash", "line_comment", "block_comment", "block_comment_star", "string_literal", "char_literal"
+};
 
-    FILE *in = fopen(argv[1], "r");                                   /* Open original source file for reading. */
-    if (!in) {                                                        /* fopen returns NULL on failure. */
-        perror("Unable to open input file");                          /* perror prints OS-specific reason. */
-        return EXIT_FAILURE;                                          /* Bail out because we cannot proceed. */
-    }
+typedef struct {
+    ScannerState state;      /* Current finite-state machine position. */
+    bool string_escape;      /* True when last char in string was backslash. */
+    bool char_escape;        /* True when last char in char literal was backslash. */
+    long long comment_lines; /* Tracks how many lines contained comments (64-bit for multi-GB inputs). */
+} Scanner;
 
-    FILE *out = fopen(argv[2], "w");                                  /* Create destination file to store stripped code. */
-    if (!out) {                                                       /* If creation fails we must clean up. */
-        perror("Unable to open output file");                         /* Report the issue to the user. */
-        fclose(in);                                                   /* Close the already-open input file. */
-        return EXIT_FAILURE;                                          /* Abort execution with failure status. */
+static void scanner_init(Scanner *sc) {
+    sc->state = STATE_NORMAL;                                         /* Start outside comments and literals. */
+    sc->string_escape = false;                                        /* No pending escape in strings. */
+    sc->char_escape = false;                                          /* No pending escape in char literals. */
+    sc->comment_lines = 0;                                            /* Nothing counted yet. */
+}
+
+static void scanner_finish(const Scanner *sc, FILE *out) {
+    if (sc->state == STATE_AFTER_SLASH) {                             /* File ended right after a single '/'. */
+        fputc('/', out);                                              /* Emit the slash because it is real code. */
     }
+}
 
-    int comment_lines = 0;                                            /* Tracks how many lines contained comments. */
-    ScannerState state = STATE_NORMAL;                                /* Current finite-state machine position. */
-    bool string_escape = false;                                       /* True when last char in string was backslash. */
-    bool char_escape = false;                                         /* True when last char in char literal was backslash. */
+/* Reference implementation: one fgetc/fputc per byte through the state machine. */
+static void strip_stream(FILE *in, FILE *out, Scanner *sc) {
     int c;                                                            /* Holds each character read from input. */
+    SI_RUN_BEGIN(run);
 
     while ((c = fgetc(in)) != EOF) {                                  /* Read characters until the stream ends. */
-        switch (state) {                                              /* Branch based on current scanner state. */
+        SI_RUN_STEP(run, sc->state, 1);                               /* The byte belongs to the state it was read in. */
+        switch (sc->state) {                                          /* Branch based on current scanner state. */
         case STATE_NORMAL:                                            /* Default: outside comments or quotes. */
             if (c == '/') {                                           /* Slash may start a comment, so inspect next char. */
-                state = STATE_AFTER_SLASH;                            /* Transition so we can look ahead. */
+                sc->state = STATE_AFTER_SLASH;                        /* Transition so we can look ahead. */
             } else {                                                  /* Any other character is emitted immediately. */
                 fputc(c, out);                                        /* Copy non-comment characters to output. */
                 if (c == '"') {                                       /* Detect start of a string literal. */
-                    state = STATE_STRING_LITERAL;                     /* Track string literal to preserve content. */
-                    string_escape = false;                            /* Reset escape tracker for string context. */
+                    sc->state = STATE_STRING_LITERAL;                 /* Track string literal to preserve content. */
+                    sc->string_escape = false;                        /* Reset escape tracker for string context. */
                 } else if (c == '\'') {                               /* Detect start of a character literal. */
-                    state = STATE_CHAR_LITERAL;                       /* Switch state for char literal handling. */
-                    char_escape = false;                              /* Reset escape tracker for char context. */
+                    sc->state = STATE_CHAR_LITERAL;                   /* Switch state for char literal handling. */
+                    sc->char_escape = false;                          /* Reset escape tracker for char context. */
                 }
             }
             break;                                                    /* Leave switch once we handled the character. */
 
         case STATE_AFTER_SLASH:                                       /* We previously saw a '/'. */
             if (c == '/') {                                           /* Second slash means a // comment. */
-                state = STATE_LINE_COMMENT;                           /* Move to line comment state. */
-                comment_lines++;                                      /* Count the line that contains the comment. */
+                sc->state = STATE_LINE_COMMENT;                       /* Move to line comment state. */
+                sc->comment_lines++;                                  /* Count the line that contains the comment. */
             } else if (c == '*') {                                    /* Slash-star begins a block comment. */
-                state = STATE_BLOCK_COMMENT;                          /* Enter block comment state. */
-                comment_lines++;                                      /* Count the first line of the block comment. */
+                sc->state = STATE_BLOCK_COMMENT;                      /* Enter block comment state. */
+                sc->comment_lines++;                                  /* Count the first line of the block comment. */
             } else {                                                  /* Not a comment, keep both characters. */
                 fputc('/', out);                                      /* Output the slash since it is regular text. */
                 fputc(c, out);                                        /* Output the current character as well. */
                 if (c == '"') {                                       /* Slash followed by quote starts string literal. */
-                    state = STATE_STRING_LITERAL;                     /* Switch to string state to preserve escapes. */
-                    string_escape = false;
+                    sc->state = STATE_STRING_LITERAL;                 /* Switch to string state to preserve escapes. */
+                    sc->string_escape = false;
                 } else if (c == '\'') {                               /* Slash followed by single quote. */
-                    state = STATE_CHAR_LITERAL;                       /* Switch to char literal state. */
-                    char_escape = false;
+                    sc->state = STATE_CHAR_LITERAL;                   /* Switch to char literal state. */
+                    sc->char_escape = false;
                 } else {                                              /* No special construct, return to normal. */
-                    state = STATE_NORMAL;
+                    sc->state = STATE_NORMAL;
                 }
             }
             break;
@@ -89,63 +130,777 @@ int main(int argc, char **argv) {
         case STATE_LINE_COMMENT:                                      /* Inside // comment, drop characters until newline. */
             if (c == '\n') {                                          /* Newline ends a line comment. */
                 fputc('\n', out);                                     /* Preserve line structure in output. */
-                state = STATE_NORMAL;                                 /* Resume normal processing afterwards. */
+                sc->state = STATE_NORMAL;                             /* Resume normal processing afterwards. */
             }
             break;
 
         case STATE_BLOCK_COMMENT:                                     /* Inside /* ... comment body. */
             if (c == '\n') {                                          /* Each newline extends the comment to new line. */
-                comment_lines++;                                      /* Count the additional comment line. */
+                sc->comment_lines++;                                  /* Count the additional comment line. */
                 fputc('\n', out);                                     /* Preserve blank lines so formatting stays. */
             } else if (c == '*') {                                    /* '*' might signal the end if followed by '/'. */
-                state = STATE_BLOCK_COMMENT_STAR;                     /* Transition to look for the trailing slash. */
+                sc->state = STATE_BLOCK_COMMENT_STAR;                 /* Transition to look for the trailing slash. */
             }
             break;
 
         case STATE_BLOCK_COMMENT_STAR:                                /* Saw '*' while inside block comment. */
             if (c == '/') {                                           /* '*' followed by '/' ends the comment. */
-                state = STATE_NORMAL;                                 /* Return to normal processing state. */
+                sc->state = STATE_NORMAL;                             /* Return to normal processing state. */
             } else {                                                  /* Comment continues. */
                 if (c == '\n') {                                      /* Handle newline inside the comment. */
-                    comment_lines++;                                  /* Count the line touched by comment text. */
+                    sc->comment_lines++;                              /* Count the line touched by comment text. */
                     fputc('\n', out);                                 /* Maintain layout in the output file. */
                 }
-                state = (c == '*') ? STATE_BLOCK_COMMENT_STAR         /* Another '*' keeps us waiting for '/'. */
-                                    : STATE_BLOCK_COMMENT;            /* Otherwise we are back inside comment body. */
+                sc->state = (c == '*') ? STATE_BLOCK_COMMENT_STAR     /* Another '*' keeps us waiting for '/'. */
+                                       : STATE_BLOCK_COMMENT;         /* Otherwise we are back inside comment body. */
             }
             break;
 
         case STATE_STRING_LITERAL:                                    /* Inside a double-quoted string. */
             fputc(c, out);                                            /* Strings must be copied verbatim. */
-            if (string_escape) {                                      /* Previous char was backslash, so ignore special meaning. */
-                string_escape = false;                                /* Reset escape flag after using it. */
+            if (sc->string_escape) {                                  /* Previous char was backslash, so ignore special meaning. */
+                sc->string_escape = false;                            /* Reset escape flag after using it. */
             } else if (c == '\\') {                                   /* Backslash starts an escape sequence. */
-                string_escape = true;                                 /* Remember so the next char is treated literally. */
+                sc->string_escape = true;                             /* Remember so the next char is treated literally. */
             } else if (c == '"') {                                    /* Closing quote ends the string literal. */
-                state = STATE_NORMAL;                                 /* Return to normal scanning. */
+                sc->state = STATE_NORMAL;                             /* Return to normal scanning. */
             }
             break;
 
         case STATE_CHAR_LITERAL:                                      /* Inside a single-quoted character constant. */
             fputc(c, out);                                            /* Copy characters to keep literal intact. */
-            if (char_escape) {                                        /* Previous char was backslash. */
-                char_escape = false;                                  /* Reset escape once consumed. */
+            if (sc->char_escape) {                                    /* Previous char was backslash. */
+                sc->char_escape = false;                              /* Reset escape once consumed. */
             } else if (c == '\\') {                                   /* Start of an escape sequence within char literal. */
-                char_escape = true;                                   /* Flag so next character is taken literally. */
+                sc->char_escape = true;                               /* Flag so next character is taken literally. */
             } else if (c == '\'') {                                   /* Closing single quote ends the literal. */
-                state = STATE_NORMAL;                                 /* Resume normal scanning. */
+                sc->state = STATE_NORMAL;                             /* Resume normal scanning. */
             }
             break;
         }
     }
+    SI_RUN_END(run);
+}
 
-    if (state == STATE_AFTER_SLASH) {                                 /* File ended right after a single '/'. */
-        fputc('/', out);                                              /* Emit the slash because it is real code. */
+/*
+ * Returns a pointer to the first byte in [p, end) equal to a, b or c, or end if
+ * there is none. With SSE2 sixteen bytes are compared per step; the scalar tail
+ * handles whatever is left over.
+ */
+static const unsigned char *find_any(const unsigned char *p, const unsigned char *end,
+                                     unsigned char a, unsigned char b, unsigned char c) {
+#if defined(__SSE2__)
+    const __m128i va = _mm_set1_epi8((char)a);                        /* Broadcast each stop byte to all 16 lanes. */
+    const __m128i vb = _mm_set1_epi8((char)b);
+    const __m128i vc = _mm_set1_epi8((char)c);
+    while (end - p >= 16) {                                           /* Full 16-byte blocks only. */
+        __m128i v = _mm_loadu_si128((const __m128i *)p);              /* Unaligned load is fine on mapped memory. */
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va),
+                                                _mm_cmpeq_epi8(v, vb)),
+                                   _mm_cmpeq_epi8(v, vc));            /* 0xFF in every lane holding a stop byte. */
+        int mask = _mm_movemask_epi8(hit);                            /* One bit per lane. */
+        if (mask != 0) {                                              /* At least one interesting byte in this block. */
+            return p + __builtin_ctz((unsigned)mask);                 /* Lowest set bit is the first match. */
+        }
+        p += 16;                                                      /* Whole block was plain text, skip it. */
+    }
+#endif
+    while (p < end && *p != a && *p != b && *p != c) {                /* Scalar tail (or whole scan without SSE2). */
+        p++;
+    }
+    return p;
+}
+
+/*
+ * Destination for stripped output. Bytes go to fp when it is set, otherwise
+ * into mem when it is set; with neither, they are only counted. The counting
+ * form lets speculative scans measure their output without producing it.
+ */
+typedef struct {
+    FILE *fp;                /* Stream destination, or NULL. */
+    unsigned char *mem;      /* Memory destination, or NULL. */
+    size_t len;              /* Bytes produced so far. */
+} OutSink;
+
+static void sink_write(OutSink *s, const unsigned char *p, size_t n) {
+    if (s->fp) {
+        fwrite(p, 1, n, s->fp);                                       /* Buffered stdio write. */
+    } else if (s->mem) {
+        memcpy(s->mem + s->len, p, n);                                /* Caller sized mem for the worst case. */
+    }
+    s->len += n;
+}
+
+static void sink_put(OutSink *s, int c) {
+    if (s->fp) {
+        fputc(c, s->fp);
+    } else if (s->mem) {
+        s->mem[s->len] = (unsigned char)c;
+    }
+    s->len++;
+}
+
+/* Writes the plain run [from, to) with one bulk call. */
+static void emit_run(const unsigned char *from, const unsigned char *to, OutSink *out) {
+    if (to > from) {                                                  /* Skip empty runs. */
+        sink_write(out, from, (size_t)(to - from));                   /* Single bulk write for the whole run. */
+    }
+}
+
+/*
+ * Fast path over an in-memory buffer. Produces exactly the same output and
+ * comment count as strip_stream, but only visits the bytes that can change the
+ * state: '/', '"' and '\'' in normal code, '\n' in line comments, '*' and '\n'
+ * in block comments, and the quote or backslash inside literals.
+ */
+static void strip_buffer(const unsigned char *buf, size_t len, OutSink *out, Scanner *sc) {
+    const unsigned char *p = buf;                                     /* Cursor into the mapped input. */
+    const unsigned char *end = buf + len;                             /* One past the last byte. */
+    const unsigned char *stop;                                        /* Next interesting byte found by find_any. */
+    int c;                                                            /* Byte that triggered a transition. */
+
+    while (p < end) {                                                 /* Every iteration consumes at least one byte. */
+        switch (sc->state) {
+        case STATE_NORMAL:                                            /* Copy code up to the next '/' or quote. */
+            stop = find_any(p, end, '/', '"', '\'');
+            SI_SPAN(STATE_NORMAL, stop - p + (stop < end));          /* The run plus the byte that ends it. */
+            emit_run(p, stop, out);                                   /* Plain code goes out in one piece. */
+            if (stop == end) {                                        /* No more interesting bytes in the buffer. */
+                return;
+            }
+            c = *stop;
+            p = stop + 1;
+            if (c == '/') {                                           /* Possible comment start. */
+                sc->state = STATE_AFTER_SLASH;
+            } else {                                                  /* Opening quote is copied and entered. */
+                sink_put(out, c);
+                if (c == '"') {
+                    sc->state = STATE_STRING_LITERAL;
+                    sc->string_escape = false;
+                } else {
+                    sc->state = STATE_CHAR_LITERAL;
+                    sc->char_escape = false;
+                }
+            }
+            break;
+
+        case STATE_AFTER_SLASH:                                       /* One-byte lookahead, same rules as strip_stream. */
+            SI_SPAN(STATE_AFTER_SLASH, 1);
+            c = *p++;
+            if (c == '/') {
+                sc->state = STATE_LINE_COMMENT;
+                sc->comment_lines++;
+            } else if (c == '*') {
+                sc->state = STATE_BLOCK_COMMENT;
+                sc->comment_lines++;
+            } else {
+                sink_put(out, '/');
+                sink_put(out, c);
+                if (c == '"') {
+                    sc->state = STATE_STRING_LITERAL;
+                    sc->string_escape = false;
+                } else if (c == '\'') {
+                    sc->state = STATE_CHAR_LITERAL;
+                    sc->char_escape = false;
+                } else {
+                    sc->state = STATE_NORMAL;
+                }
+            }
+            break;
+
+        case STATE_LINE_COMMENT:                                      /* Drop everything up to the newline. */
+            stop = memchr(p, '\n', (size_t)(end - p));                /* libc memchr is already vectorised. */
+            SI_SPAN(STATE_LINE_COMMENT, (stop ? stop + 1 : end) - p);
+            if (stop == NULL) {                                       /* Comment runs to the end of the buffer. */
+                return;
+            }
+            sink_put(out, '\n');                                      /* Preserve line structure in output. */
+            sc->state = STATE_NORMAL;
+            p = stop + 1;
+            break;
+
+        case STATE_BLOCK_COMMENT:                                     /* Only '*' and '\n' matter inside the body. */
+            stop = find_any(p, end, '*', '\n', '\n');
+            SI_SPAN(STATE_BLOCK_COMMENT, stop - p + (stop < end));
+            if (stop == end) {
+                return;
+            }
+            p = stop + 1;
+            if (*stop == '\n') {                                      /* Newline extends the comment to a new line. */
+                sc->comment_lines++;
+                sink_put(out, '\n');
+            } else {                                                  /* '*' may be followed by the closing '/'. */
+                sc->state = STATE_BLOCK_COMMENT_STAR;
+            }
+            break;
+
+        case STATE_BLOCK_COMMENT_STAR:                                /* One-byte lookahead for the closing '/'. */
+            SI_SPAN(STATE_BLOCK_COMMENT_STAR, 1);
+            c = *p++;
+            if (c == '/') {
+                sc->state = STATE_NORMAL;
+            } else {
+                if (c == '\n') {
+                    sc->comment_lines++;
+                    sink_put(out, '\n');
+                }
+                sc->state = (c == '*') ? STATE_BLOCK_COMMENT_STAR
+                                       : STATE_BLOCK_COMMENT;
+            }
+            break;
+
+        case STATE_STRING_LITERAL:                                    /* Copy up to the closing quote or a backslash. */
+        case STATE_CHAR_LITERAL: {
+            bool is_string = (sc->state == STATE_STRING_LITERAL);
+            bool *escape = is_string ? &sc->string_escape : &sc->char_escape;
+            unsigned char quote = is_string ? '"' : '\'';
+            if (*escape) {                                            /* Escaped byte is copied without inspection. */
+                SI_SPAN(sc->state, 1);
+                sink_put(out, *p++);
+                *escape = false;
+                break;
+            }
+            stop = find_any(p, end, quote, '\\', '\\');
+            SI_SPAN(sc->state, stop - p + (stop < end));
+            if (stop == end) {                                        /* Literal continues past the buffer end. */
+                emit_run(p, end, out);
+                return;
+            }
+            emit_run(p, stop + 1, out);                               /* Literal text plus the stop byte itself. */
+            p = stop + 1;
+            if (*stop == '\\') {
+                *escape = true;                                       /* Next byte is taken literally. */
+            } else {
+                sc->state = STATE_NORMAL;                             /* Closing quote ends the literal. */
+            }
+            break;
+        }
+        }
+    }
+}
+
+/* Maps the whole input file read-only. Returns 0 on success, -1 after printing an error. */
+static int map_input(const char *path, const unsigned char **data, size_t *len) {
+    int fd = open(path, O_RDONLY);                                    /* Raw descriptor for mmap. */
+    if (fd < 0) {
+        perror("Unable to open input file");
+        return -1;
+    }
+
+    struct stat st;                                                   /* File metadata, we only need the size. */
+    if (fstat(fd, &st) != 0) {
+        perror("Unable to stat input file");
+        close(fd);
+        return -1;
+    }
+
+    *len = (size_t)st.st_size;
+    *data = NULL;
+    if (*len > 0) {                                                   /* mmap rejects zero-length mappings. */
+        void *m = mmap(NULL, *len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) {
+            perror("Unable to map input file");
+            close(fd);
+            return -1;
+        }
+        posix_madvise(m, *len, POSIX_MADV_SEQUENTIAL);                /* Hint aggressive read-ahead; failure is harmless. */
+        *data = m;
+    }
+    close(fd);                                                        /* The mapping stays valid after close. */
+    return 0;
+}
+
+static void unmap_input(const unsigned char *data, size_t len) {
+    if (data != NULL) {
+        munmap((void *)data, len);
+    }
+}
+
+/*
+ * Parallel mode. The input is cut into chunks, but the scanner state at the
+ * start of a chunk depends on everything before it. A worker that claims a chunk
+ * before its predecessor is finished strips it speculatively from every possible
+ * entry state; when the predecessor's exit state arrives, the matching result is
+ * written and the chunk's own exit state is handed on. Chunks are written in file
+ * order, one after the other, through plain write() calls.
+ */
+enum {
+    ENTRY_STATES = 9,                /* Five plain states plus string/char literal with and without a pending escape. */
+    ENTRY_STRING_ESCAPE = 7,         /* Index of "inside string, previous char was a backslash". */
+    ENTRY_CHAR_ESCAPE = 8,           /* Index of "inside char literal, previous char was a backslash". */
+    SPEC_BLOCK = 64 * 1024           /* Speculative scans compare their states after every block this size. */
+};
+
+/* Packs state and escape flags into 0..ENTRY_STATES-1; the flags are only ever set inside their literal. */
+static int scanner_entry(const Scanner *sc) {
+    if (sc->state == STATE_STRING_LITERAL && sc->string_escape) {
+        return ENTRY_STRING_ESCAPE;
+    }
+    if (sc->state == STATE_CHAR_LITERAL && sc->char_escape) {
+        return ENTRY_CHAR_ESCAPE;
+    }
+    return (int)sc->state;                                            /* STATE_NORMAL .. STATE_CHAR_LITERAL are 0..6. */
+}
+
+static void scanner_from_entry(Scanner *sc, int entry) {
+    scanner_init(sc);
+    if (entry == ENTRY_STRING_ESCAPE) {
+        sc->state = STATE_STRING_LITERAL;
+        sc->string_escape = true;
+    } else if (entry == ENTRY_CHAR_ESCAPE) {
+        sc->state = STATE_CHAR_LITERAL;
+        sc->char_escape = true;
+    } else {
+        sc->state = (ScannerState)entry;
+    }
+}
+
+typedef struct {
+    const unsigned char *data;              /* First byte of the chunk inside the mapping. */
+    size_t len;                             /* Chunk length in bytes. */
+    int exit_entry[ENTRY_STATES];           /* State at the chunk end, per entry state. */
+    long long comments[ENTRY_STATES];       /* Comment lines counted inside the chunk, per entry state. */
+    size_t rejoin[ENTRY_STATES];            /* Input offset from which an entry's output is the normal entry's, or len. */
+    size_t rejoin_out[ENTRY_STATES];        /* Normal-entry output bytes produced before that offset. */
+} Chunk;
+
+typedef struct {
+    const unsigned char *data;              /* The whole mapped input. */
+    size_t len;                             /* Input length in bytes. */
+    size_t chunk;                           /* Length of every chunk but the last. */
+    size_t count;                           /* Number of chunks. */
+    atomic_size_t next;                     /* Next unclaimed chunk; workers take chunks dynamically, in order. */
+    int out_fd;                             /* Output descriptor, written at its current position. */
+    size_t written;                         /* Chunks already written. */
+    int entry;                              /* Entry state of chunk `written`. */
+    long long comment_lines;                /* Comment lines of the chunks written so far. */
+    pthread_mutex_t lock;                   /* Guards written, entry and comment_lines. */
+    pthread_cond_t turn;                    /* Signalled whenever written advances. */
+    atomic_bool failed;                     /* Set by any worker whose allocation or write fails. */
+} ParallelJob;
+
+/*
+ * Runs all entry states over the chunk block by block; the normal entry writes
+ * its output to normal_out, the others only count. Real code makes the scanners
+ * converge quickly (a closing quote or newline usually brings them back to the
+ * same state); once two agree at a block boundary they agree for the rest of the
+ * chunk, so the later one stops and inherits the earlier one's result plus
+ * whatever it had counted differently until then.
+ */
+static void speculate_chunk(Chunk *ch, OutSink *normal_out) {
+    Scanner sc[ENTRY_STATES];                                         /* One scanner per hypothesis. */
+    OutSink sink[ENTRY_STATES];                                       /* Counting sinks, except the normal entry's. */
+    int alias[ENTRY_STATES];                                          /* -1 while live, else the scanner it merged into. */
+    long long comment_delta[ENTRY_STATES];                            /* Count difference at the merge point. */
+
+    for (int k = 0; k < ENTRY_STATES; ++k) {
+        scanner_from_entry(&sc[k], k);
+        sink[k] = (OutSink){ NULL, NULL, 0 };
+        alias[k] = -1;
+        ch->rejoin[k] = ch->len;
+        ch->rejoin_out[k] = 0;
+    }
+    sink[STATE_NORMAL] = *normal_out;
+    ch->rejoin[STATE_NORMAL] = 0;
+
+    SI_TIME_BEGIN(scan_start);
+    SI_SUSPEND(real_counts);                                          /* Hypothetical states would swamp the real ones. */
+    for (size_t off = 0; off < ch->len; off += SPEC_BLOCK) {
+        size_t n = (ch->len - off < SPEC_BLOCK) ? ch->len - off : SPEC_BLOCK;
+        for (int k = 0; k < ENTRY_STATES; ++k) {
+            if (alias[k] < 0) {
+                strip_buffer(ch->data + off, n, &sink[k], &sc[k]);
+            }
+        }
+        for (int k = 1; k < ENTRY_STATES; ++k) {                      /* Merge each live scanner into an earlier live twin. */
+            if (alias[k] >= 0) {
+                continue;
+            }
+            for (int j = 0; j < k; ++j) {
+                if (alias[j] < 0 && scanner_entry(&sc[j]) == scanner_entry(&sc[k])) {
+                    alias[k] = j;
+                    comment_delta[k] = sc[k].comment_lines - sc[j].comment_lines;
+                    if (j == STATE_NORMAL) {                          /* From here on its output is the normal one. */
+                        ch->rejoin[k] = off + n;
+                        ch->rejoin_out[k] = sink[STATE_NORMAL].len;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    SI_RESUME(real_counts);
+    SI_TIME_END(scan_start, SI_SCAN);
+    *normal_out = sink[STATE_NORMAL];
+
+    for (int k = 0; k < ENTRY_STATES; ++k) {                          /* Aliases always point lower, so resolve upwards. */
+        int j = alias[k];
+        if (j < 0) {
+            ch->exit_entry[k] = scanner_entry(&sc[k]);
+            ch->comments[k] = sc[k].comment_lines;
+        } else {
+            ch->exit_entry[k] = ch->exit_entry[j];
+            ch->comments[k] = ch->comments[j] + comment_delta[k];
+            if (j != STATE_NORMAL) {                                  /* Rejoins wherever its twin does, which is later. */
+                ch->rejoin[k] = ch->rejoin[j];
+                ch->rejoin_out[k] = ch->rejoin_out[j];
+            }
+        }
+    }
+}
+
+/* Writes all of buf at the descriptor's current position. */
+static bool write_all(int fd, const unsigned char *buf, size_t len) {
+    size_t done = 0;
+    while (done < len) {                                              /* write() may write less than asked. */
+        ssize_t w = write(fd, buf + done, len - done);
+        if (w <= 0) {
+            return false;
+        }
+        done += (size_t)w;
+    }
+    return true;
+}
+
+/*
+ * Writes chunk ch for its real entry state. The normal entry's output is in
+ * normal[0..normal_len); any other entry re-strips the prefix up to where its
+ * scanner fell in step with the normal one and takes the rest from there.
+ */
+static bool write_chunk(int fd, const Chunk *ch, int entry, const unsigned char *normal, size_t normal_len) {
+    size_t prefix = ch->rejoin[entry];
+    size_t tail_from = (prefix < ch->len) ? ch->rejoin_out[entry] : normal_len;
+#ifdef SCANNER_INSTRUMENT
+    prefix = ch->len;                                                 /* The speculation was not counted; count the real scan. */
+    tail_from = normal_len;
+#endif
+    if (prefix == 0) {
+        return write_all(fd, normal, normal_len);
+    }
+
+    unsigned char *buf = malloc(prefix + 1);                          /* A pending '/' from the previous chunk adds one byte. */
+    if (buf == NULL) {
+        return false;
+    }
+    OutSink sink = { NULL, buf, 0 };
+    Scanner sc;
+    scanner_from_entry(&sc, entry);
+    SI_TIME_BEGIN(scan_start);
+    strip_buffer(ch->data, prefix, &sink, &sc);
+    SI_TIME_END(scan_start, SI_SCAN);
+    SI_BYTES(prefix);
+    bool ok = write_all(fd, buf, sink.len) && write_all(fd, normal + tail_from, normal_len - tail_from);
+    free(buf);
+    return ok;
+}
+
+/*
+ * Strips chunk i and writes it once chunks 0..i-1 have been written. Chunks are
+ * claimed in file order, so the chunk being waited for is always in progress.
+ * When that has already happened at claim time the entry state is known and the
+ * chunk is stripped once, from that state.
+ */
+static bool strip_chunk(ParallelJob *job, size_t i) {
+    Chunk ch;
+    ch.data = job->data + i * job->chunk;
+    ch.len = (i + 1 < job->count) ? job->chunk : job->len - i * job->chunk;
+    unsigned char *buf = malloc(ch.len + 1);                          /* NULL still lets the states be chained. */
+    OutSink normal = { NULL, buf, 0 };
+
+    pthread_mutex_lock(&job->lock);
+    bool known = job->written == i;
+    int entry = job->entry;
+    pthread_mutex_unlock(&job->lock);
+
+    if (known) {
+        Scanner sc;
+        scanner_from_entry(&sc, entry);
+        SI_TIME_BEGIN(scan_start);
+        strip_buffer(ch.data, ch.len, &normal, &sc);
+        SI_TIME_END(scan_start, SI_SCAN);
+        SI_BYTES(ch.len);
+        ch.exit_entry[entry] = scanner_entry(&sc);
+        ch.comments[entry] = sc.comment_lines;
+    } else {
+        speculate_chunk(&ch, &normal);
+        pthread_mutex_lock(&job->lock);
+        while (job->written != i) {
+            pthread_cond_wait(&job->turn, &job->lock);
+        }
+        entry = job->entry;
+        pthread_mutex_unlock(&job->lock);
+    }
+
+    SI_TIME_BEGIN(io_start);
+    bool ok = buf != NULL && !atomic_load(&job->failed)
+              && (known ? write_all(job->out_fd, buf, normal.len)     /* buf already holds the real output. */
+                        : write_chunk(job->out_fd, &ch, entry, buf, normal.len));
+    SI_TIME_END(io_start, SI_IO);
+    free(buf);
+
+    pthread_mutex_lock(&job->lock);
+    job->entry = ch.exit_entry[entry];
+    job->comment_lines += ch.comments[entry];
+    job->written++;                                                   /* Advance even on failure so no worker waits forever. */
+    pthread_cond_broadcast(&job->turn);
+    pthread_mutex_unlock(&job->lock);
+    return ok;
+}
+
+static void *parallel_worker(void *arg) {
+    ParallelJob *job = arg;
+    size_t i;
+
+    while ((i = atomic_fetch_add(&job->next, 1)) < job->count) {      /* Claim chunks until none are left. */
+        if (!strip_chunk(job, i)) {
+            atomic_store(&job->failed, true);
+        }
+    }
+    SI_THREAD_FLUSH();                                                /* Thread-local counters die with the thread. */
+    return NULL;
+}
+
+static bool run_workers(ParallelJob *job, int threads) {
+    pthread_t tid[threads];                                           /* Small VLA: one handle per worker. */
+    int started = 0;
+
+    atomic_store(&job->next, 0);
+    for (; started < threads; ++started) {
+        if (pthread_create(&tid[started], NULL, parallel_worker, job) != 0) {
+            break;                                                    /* Fewer threads is slower but still correct. */
+        }
+    }
+    if (started == 0) {
+        parallel_worker(job);                                         /* No threads at all: do the work inline. */
+    }
+    for (int t = 0; t < started; ++t) {
+        pthread_join(tid[t], NULL);
+    }
+    return !atomic_load(&job->failed);
+}
+
+/*
+ * Strips data[0..len) into out_fd, from its current position, using the given
+ * number of threads. Output and comment count are identical to the serial paths.
+ * Returns 0 on success.
+ */
+static int strip_parallel(const unsigned char *data, size_t len, int out_fd, int threads,
+                          long long *comment_lines) {
+    size_t chunk = len / ((size_t)threads * 4);                       /* A few chunks per thread balances uneven chunks. */
+    if (chunk < (1u << 20)) chunk = 1u << 20;                         /* Below 1 MiB the speculation overhead dominates. */
+    if (chunk > (64u << 20)) chunk = 64u << 20;                       /* Bounds the per-thread output buffer. */
+
+    ParallelJob job = { .data = data, .len = len, .chunk = chunk, .count = (len + chunk - 1) / chunk,
+                        .out_fd = out_fd, .written = 0, .entry = STATE_NORMAL, .comment_lines = 0 };
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.turn, NULL);
+    atomic_init(&job.failed, false);
+    bool ok = run_workers(&job, threads);
+
+    if (ok && job.entry == STATE_AFTER_SLASH) {                       /* Same rule as scanner_finish. */
+        ok = write_all(out_fd, (const unsigned char *)"/", 1);
+    }
+    if (!ok) {
+        perror("Unable to write output file");
+    }
+    *comment_lines = job.comment_lines;
+    pthread_cond_destroy(&job.turn);
+    pthread_mutex_destroy(&job.lock);
+    return ok ? 0 : -1;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);                              /* Monotonic clock is immune to wall-clock jumps. */
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Compares two streams from the start; returns true if their contents are identical. */
+static bool same_contents(FILE *a, FILE *b) {
+    unsigned char ba[65536], bb[65536];                               /* Compare in 64 KiB blocks. */
+    size_t na, nb;
+
+    rewind(a);
+    rewind(b);
+    do {
+        na = fread(ba, 1, sizeof(ba), a);
+        nb = fread(bb, 1, sizeof(bb), b);
+        if (na != nb || memcmp(ba, bb, na) != 0) {
+            return false;
+        }
+    } while (na > 0);
+    return true;
+}
+
+
+/* Runs every implementation, verifies they agree and reports their throughput. */
+static int run_bench(const char *in_path, const char *out_path, int threads) {
+    const unsigned char *data;
+    size_t len;
+    if (map_input(in_path, &data, &len) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    FILE *in = fopen(in_path, "r");                                   /* The byte path still reads through stdio. */
+    FILE *slow_out = fopen(out_path, "w+");                           /* Reference output goes to the requested file. */
+    FILE *fast_out = tmpfile();                                       /* Fast output is compared against it. */
+    FILE *par_out = tmpfile();                                        /* So is the parallel output. */
+    if (!in || !slow_out || !fast_out || !par_out) {
+        perror("Unable to open benchmark files");
+        if (in) fclose(in);
+        if (slow_out) fclose(slow_out);
+        if (fast_out) fclose(fast_out);
+        if (par_out) fclose(par_out);
+        unmap_input(data, len);
+        return EXIT_FAILURE;
     }
 
-    printf("Total comment lines in %s: %d\n", argv[1], comment_lines);/* Report how many lines contained comments. */
+    Scanner slow, fast;
+    scanner_init(&slow);
+    scanner_init(&fast);
+    OutSink fast_sink = { fast_out, NULL, 0 };
+    long long par_comments = 0;
+
+    double t0 = now_seconds();
+    strip_stream(in, slow_out, &slow);                                /* Byte-at-a-time reference. */
+    scanner_finish(&slow, slow_out);
+    fflush(slow_out);
+    double t1 = now_seconds();
+    strip_buffer(data, len, &fast_sink, &fast);                       /* Vectorised mapped path. */
+    scanner_finish(&fast, fast_out);
+    fflush(fast_out);
+    double t2 = now_seconds();
+    int par_status = strip_parallel(data, len, fileno(par_out), threads, &par_comments);
+    double t3 = now_seconds();
+
+    bool identical = par_status == 0
+                     && slow.comment_lines == fast.comment_lines
+                     && slow.comment_lines == par_comments
+                     && same_contents(slow_out, fast_out)
+                     && same_contents(slow_out, par_out);
+    double mb = (double)len / (1024.0 * 1024.0);
+
+    printf("Total comment lines in %s: %lld\n", in_path, slow.comment_lines);
+    printf("byte-at-a-time : %10.3f s %10.1f MB/s\n", t1 - t0, (t1 > t0) ? mb / (t1 - t0) : 0.0);
+    printf("mmap + vector  : %10.3f s %10.1f MB/s\n", t2 - t1, (t2 > t1) ? mb / (t2 - t1) : 0.0);
+    printf("parallel x%-4d : %10.3f s %10.1f MB/s\n", threads, t3 - t2, (t3 > t2) ? mb / (t3 - t2) : 0.0);
+    printf("outputs %s\n", identical ? "identical" : "DIFFER");
+
+    fclose(in);
+    fclose(slow_out);
+    fclose(fast_out);
+    fclose(par_out);
+    unmap_input(data, len);
+    return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--fast | --threads N | --bench [--threads N]] <input.c> <output.c>\n", prog); /* Remind user about correct syntax. */
+    return EXIT_FAILURE;                                              /* Non-zero exit signals incorrect usage. */
+}
+
+int main(int argc, char **argv) {
+    bool fast = false;                                                /* --fast selects the mapped path. */
+    bool bench = false;                                               /* --bench compares all paths. */
+    int threads = 0;                                                  /* --threads N selects the parallel path. */
+    int first = 1;                                                    /* Index of the first positional argument. */
+
+    while (first < argc && strncmp(argv[first], "--", 2) == 0) {      /* Leading options, in any order. */
+        if (strcmp(argv[first], "--fast") == 0) {
+            fast = true;
+        } else if (strcmp(argv[first], "--bench") == 0) {
+            bench = true;
+        } else if (strcmp(argv[first], "--threads") == 0 && first + 1 < argc) {
+            threads = atoi(argv[++first]);
+            if (threads < 1) {
+                return usage(argv[0]);
+            }
+            if (threads > MAX_THREADS) {
+                threads = MAX_THREADS;
+            }
+        } else {
+            return usage(argv[0]);
+        }
+        first++;
+    }
+    if (argc - first != 2 || (fast && threads > 0)) {                 /* Expect input and output path after the options. */
+        return usage(argv[0]);
+    }
+    if (threads == 1 && !bench) {                                     /* One worker gains nothing over the serial fast path. */
+        fast = true;
+        threads = 0;
+    }
+
+    const char *in_path = argv[first];
+    const char *out_path = argv[first + 1];
+
+    if (bench) {
+        if (threads == 0) {
+            long online = sysconf(_SC_NPROCESSORS_ONLN);              /* Default to one worker per online core. */
+            threads = (online > 0) ? (int)(online < MAX_THREADS ? online : MAX_THREADS) : 1;
+        }
+        return run_bench(in_path, out_path, threads);
+    }
+
+    SI_INIT("practical03c_strip_comments", state_names, (int)(sizeof(state_names) / sizeof(state_names[0])), NULL, 0);
+    SI_TIME_BEGIN(open_start);
+    const unsigned char *data = NULL;                                 /* Mapped input for the fast and parallel paths. */
+    size_t len = 0;
+    FILE *in = NULL;                                                  /* stdio input for the byte path. */
+
+    if (fast || threads > 0) {
+        if (map_input(in_path, &data, &len) != 0) {                   /* Errors are already reported. */
+            return EXIT_FAILURE;
+        }
+    } else {
+        in = fopen(in_path, "r");                                     /* Open original source file for reading. */
+        if (!in) {                                                    /* fopen returns NULL on failure. */
+            perror("Unable to open input file");                      /* perror prints OS-specific reason. */
+            return EXIT_FAILURE;                                      /* Bail out because we cannot proceed. */
+        }
+    }
+
+    FILE *out = fopen(out_path, "w");                                 /* Create destination file to store stripped code. */
+    if (!out) {                                                       /* If creation fails we must clean up. */
+        perror("Unable to open output file");                         /* Report the issue to the user. */
+        if (in) fclose(in);                                           /* Close the already-open input file. */
+        unmap_input(data, len);
+        return EXIT_FAILURE;                                          /* Abort execution with failure status. */
+    }
+
+    Scanner sc;
+    scanner_init(&sc);
+    int status = EXIT_SUCCESS;
+    SI_TIME_END(open_start, SI_IO);
+
+    if (threads > 0) {
+        if (strip_parallel(data, len, fileno(out), threads, &sc.comment_lines) != 0) {
+            status = EXIT_FAILURE;                                    /* Workers write through the descriptor directly. */
+        }
+    } else if (fast) {
+        OutSink sink = { out, NULL, 0 };
+        setvbuf(out, NULL, _IOFBF, 1 << 20);                          /* Large stdio buffer so bulk runs coalesce. */
+        SI_TIME_BEGIN(scan_start);
+        strip_buffer(data, len, &sink, &sc);                          /* Page faults and full-buffer writes land here too. */
+        scanner_finish(&sc, out);
+        SI_TIME_END(scan_start, SI_SCAN);
+        SI_BYTES(len);
+    } else {
+        SI_TIME_BEGIN(scan_start);
+        strip_stream(in, out, &sc);                                   /* stdio refills are interleaved, so all of it is scan time. */
+        scanner_finish(&sc, out);
+        SI_TIME_END(scan_start, SI_SCAN);
+        SI_BYTES(ftell(in));
+    }
+
+    if (status == EXIT_SUCCESS) {
+        printf("Total comment lines in %s: %lld\n", in_path, sc.comment_lines); /* Report how many lines contained comments. */
+    }
 
-    fclose(in);                                                       /* Close the input file handle. */
+    SI_TIME_BEGIN(close_start);
+    if (in) fclose(in);                                               /* Close the input file handle. */
+    unmap_input(data, len);
     fclose(out);                                                      /* Close the output file handle. */
-    return EXIT_SUCCESS;                                              /* Return zero to indicate success. */
+    SI_TIME_END(close_start, SI_IO);
+    return status;                                                    /* Return zero to indicate success. */
 }
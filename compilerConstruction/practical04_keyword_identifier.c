@@ -1,57 +1,610 @@
+#define _POSIX_C_SOURCE 200809L /* Expose clock_gettime and sysconf. */
+
 #include <stdio.h>   /* Standard I/O for printf, perror, fopen. */
-#include <string.h>  /* strcmp used to compare words against keywords. */
-#include <ctype.h>   /* Character classification helpers like isalpha. */
+#include <string.h>  /* strcmp/memcmp used to compare words against keywords. */
+#include <stdbool.h> /* bool for tokenizer flags. */
+#include <time.h>    /* clock_gettime for the benchmark. */
+#include <stdint.h>  /* Fixed-width hash and position fields. */
+#include <stdlib.h>  /* malloc / free / qsort / atoi. */
+#include <pthread.h> /* One worker per file for the symbol statistics. */
+#include <stdatomic.h> /* Shared file cursor for the workers. */
+#include <unistd.h>  /* sysconf for the default thread count. */
+#include "lexical_engine.h" /* The shared lexer this tool is a front end for. */
 
 /*
  * Simple lexical recognizer that classifies tokens as keywords, identifiers,
  * numbers, or unknown symbols. This mirrors what a minimal lexical analyser
  * would do before passing tokens to later compiler phases.
+ *
+ * Usage:
+ *   ./a.out [file]          classify every token (stdin when no file is given)
+ *   ./a.out --bench file    compare the old fscanf/strcmp loop with the engine
+ *   ./a.out --symbols [--top N] [--threads T] file...
+ *                           occurrence counts and first/last line of every identifier
+ *   ./a.out --bench-symbols file
+ *                           interned symbol table versus a malloc-per-string table
+ *
+ * Build with -pthread together with lexical_engine.c and its generated keyword
+ * table (see lexical_engine.h).
+ *
+ * Tokens come from the shared lexer in lexical_engine.c, split by maximal
+ * munch, so "int x=a+b;" yields int, x, =, a, +, b and ; rather than one
+ * whitespace-delimited word. Comments are skipped and string/character
+ * literals are reported as single tokens. Keywords are the C11 ones plus
+ * "main". Standard input is read to the end before the tokens are listed.
  */
 
-static const char *keywords[] = {
+/* The 14 words the demo originally knew; --bench times the old lookup on the old list. */
+static const char *original_keywords[] = {
     "int", "float", "char", "if", "else", "while", "for", "do", "return",
     "main", "void", "double", "break", "continue"
-};                                                                  /* Table of reserved words understood by this demo. */
-static const size_t keyword_count = sizeof(keywords) / sizeof(keywords[0]); /* Compute how many entries are in the table. */
+};
 
-static int is_keyword(const char *text) {
-    for (size_t i = 0; i < keyword_count; ++i) {                    /* Iterate over the reserved word list. */
-        if (strcmp(text, keywords[i]) == 0) {                       /* strcmp returns zero when strings are equal. */
+/* Original lookup: linear strcmp scan. Kept for the benchmark. */
+static int is_keyword_linear(const char *text) {
+    for (size_t i = 0; i < sizeof(original_keywords) / sizeof(original_keywords[0]); ++i) {
+        if (strcmp(text, original_keywords[i]) == 0) {              /* strcmp returns zero when strings are equal. */
             return 1;                                               /* Found a match, so classify as keyword. */
         }
     }
     return 0;                                                       /* No match found, thus not a keyword. */
 }
 
-int main(int argc, char **argv) {
-    FILE *fp = NULL;                                                /* File pointer for input source; defaults to stdin. */
-    char word[128];                                                 /* Buffer to hold each token extracted from input. */
+/* practical04 has always listed operators as the punctuators they are. */
+static const char *token_kind_name(LexKind kind) {
+    return lex_kind_name(kind == LEX_OPERATOR ? LEX_PUNCTUATOR : kind);
+}
 
-    if (argc == 2) {                                                /* If a filename is provided, use it. */
-        fp = fopen(argv[1], "r");                                   /* Try to open the file in read mode. */
-        if (!fp) {                                                  /* fopen returns NULL on failure. */
-            perror("Unable to open input file");                    /* Print OS-level error message. */
-            return 1;                                               /* Exit with non-zero status to signal the error. */
+/* Every kind the listing shows: whitespace and comments are skipped. */
+#define TOKEN_KINDS (LEX_ALL_KINDS & ~(LEX_KIND_BIT(LEX_SPACE) | LEX_KIND_BIT(LEX_COMMENT)))
+
+static void print_token(const LexToken *tok, void *user) {
+    (void)user;
+    printf("%-16.*s %s\n", (int)tok->len, tok->text, token_kind_name(tok->kind)); /* %-16s left-aligns tokens for neat columns. */
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Times the old whitespace-split loop against the engine, without printing. */
+static int run_bench(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        perror("Unable to open input file");
+        return 1;
+    }
+
+    char word[128];
+    size_t old_tokens = 0, old_keywords = 0;
+    double t0 = now_seconds();
+    while (fscanf(fp, "%127s", word) != EOF) {                      /* Old loop, old lookup. */
+        old_tokens++;
+        old_keywords += (size_t)is_keyword_linear(word);
+    }
+    double t1 = now_seconds();
+
+    fclose(fp);
+
+    LexSummary summary;
+    double t2 = now_seconds();
+    if (lex_engine_run_file(path, NULL, 0, &summary) != 0) {        /* Counting only: no subscriber. */
+        return 1;
+    }
+    double t3 = now_seconds();
+    size_t new_tokens = 0;
+    for (int k = 0; k < LEX_KIND_COUNT; ++k) {
+        if (TOKEN_KINDS & LEX_KIND_BIT(k)) {
+            new_tokens += (size_t)summary.tokens[k];
+        }
+    }
+
+    printf("fscanf + strcmp : %10zu tokens %10.3f s %12.0f tokens/s (%zu keywords, original 14-word list)\n",
+           old_tokens, t1 - t0, (t1 > t0) ? old_tokens / (t1 - t0) : 0.0, old_keywords);
+    printf("engine + hash   : %10zu tokens %10.3f s %12.0f tokens/s (%zu keywords, full 45-word list)\n",
+           new_tokens, t3 - t2, (t3 > t2) ? new_tokens / (t3 - t2) : 0.0, (size_t)summary.tokens[LEX_KEYWORD]);
+    return 0;
+}
+
+/*
+ * Identifier statistics. Every identifier is interned once in a SymbolTable:
+ * an open-addressing hash (FNV-1a, linear probing, at most half full) of
+ * pointers to Symbol records. Each record and its name bytes are carved out of
+ * an Arena in one bump, so a new symbol costs no malloc and a slot costs only
+ * a pointer. A symbol's first and last occurrence are kept as positions,
+ * (file index << 32) | line, so the earliest and latest sites across several
+ * files compare as plain integers. Workers build one table per thread and the
+ * tables are merged afterwards.
+ */
+#define ARENA_BLOCK (1024 * 1024)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;                                        /* Older blocks; freed together. */
+    size_t used, size;
+    _Alignas(8) char data[];                                        /* Records inside stay 8-byte aligned. */
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock *head;                                               /* Block currently being filled. */
+    size_t used;                                                    /* Bytes handed out; the rest is slack in the newest block. */
+} Arena;
+
+/* Returns n bytes aligned to 8, or NULL when out of memory. */
+static void *arena_alloc(Arena *a, size_t n) {
+    n = (n + 7) & ~(size_t)7;
+    if (a->head == NULL || a->head->size - a->head->used < n) {
+        size_t size = n > ARENA_BLOCK ? n : ARENA_BLOCK;            /* Oversized requests get a block of their own. */
+        ArenaBlock *b = malloc(sizeof(ArenaBlock) + size);
+        if (b == NULL) {
+            return NULL;
+        }
+        b->next = a->head;
+        b->used = 0;
+        b->size = size;
+        a->head = b;
+    }
+    void *p = a->head->data + a->head->used;
+    a->head->used += n;
+    a->used += n;
+    return p;
+}
+
+static void arena_free(Arena *a) {
+    while (a->head != NULL) {
+        ArenaBlock *next = a->head->next;
+        free(a->head);
+        a->head = next;
+    }
+    a->used = 0;
+}
+
+typedef struct {
+    uint64_t count;                                                 /* Occurrences. */
+    uint64_t first, last;                                           /* Positions: (file << 32) | line. */
+    uint32_t len;
+    uint32_t hash;                                                  /* Cached so growing and probing skip most memcmps. */
+    char text[];                                                    /* Name bytes follow the record; not NUL-terminated. */
+} Symbol;
+
+typedef struct {
+    Symbol **slots;                                                 /* NULL marks an empty slot. */
+    size_t capacity;                                                /* Power of two. */
+    size_t used;                                                    /* Distinct symbols. */
+    Arena arena;
+} SymbolTable;
+
+static uint32_t fnv1a(const char *text, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) {
+        h = (h ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return h;
+}
+
+static bool symtab_init(SymbolTable *t, size_t capacity) {
+    t->slots = calloc(capacity, sizeof(Symbol *));
+    t->capacity = capacity;
+    t->used = 0;
+    t->arena.head = NULL;
+    t->arena.used = 0;
+    return t->slots != NULL;
+}
+
+static void symtab_free(SymbolTable *t) {
+    free(t->slots);
+    arena_free(&t->arena);
+    t->slots = NULL;
+}
+
+/* Slot holding text, or the empty slot where it belongs. */
+static Symbol **symtab_slot(Symbol **slots, size_t capacity, const char *text, size_t len, uint32_t hash) {
+    size_t i = hash & (capacity - 1);
+    while (slots[i] != NULL
+           && !(slots[i]->hash == hash && slots[i]->len == len && memcmp(slots[i]->text, text, len) == 0)) {
+        i = (i + 1) & (capacity - 1);
+    }
+    return &slots[i];
+}
+
+static bool symtab_grow(SymbolTable *t) {
+    size_t capacity = t->capacity * 2;
+    Symbol **slots = calloc(capacity, sizeof(Symbol *));
+    if (slots == NULL) {
+        return false;
+    }
+    for (size_t i = 0; i < t->capacity; ++i) {                      /* Records stay where they are in the arena. */
+        Symbol *s = t->slots[i];
+        if (s != NULL) {
+            *symtab_slot(slots, capacity, s->text, s->len, s->hash) = s;
+        }
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->capacity = capacity;
+    return true;
+}
+
+/* Finds or adds text; a new symbol starts with count 0 and empty positions. NULL when out of memory. */
+static Symbol *symtab_lookup(SymbolTable *t, const char *text, size_t len, uint32_t hash) {
+    Symbol **slot = symtab_slot(t->slots, t->capacity, text, len, hash);
+    if (*slot != NULL) {
+        return *slot;
+    }
+    if (2 * (t->used + 1) > t->capacity) {                          /* Keep the load factor at or below 1/2. */
+        if (!symtab_grow(t)) {
+            return NULL;
+        }
+        slot = symtab_slot(t->slots, t->capacity, text, len, hash);
+    }
+    Symbol *s = arena_alloc(&t->arena, sizeof(Symbol) + len);
+    if (s == NULL) {
+        return NULL;
+    }
+    memcpy(s->text, text, len);
+    s->len = (uint32_t)len;
+    s->hash = hash;
+    s->count = 0;
+    s->first = UINT64_MAX;
+    s->last = 0;
+    *slot = s;
+    t->used++;
+    return s;
+}
+
+static bool symtab_add(SymbolTable *t, const char *text, size_t len, uint64_t pos) {
+    Symbol *s = symtab_lookup(t, text, len, fnv1a(text, len));
+    if (s == NULL) {
+        return false;
+    }
+    s->count++;
+    if (pos < s->first) s->first = pos;
+    if (pos > s->last) s->last = pos;
+    return true;
+}
+
+/* Folds src into dst; src is left untouched. */
+static bool symtab_merge(SymbolTable *dst, const SymbolTable *src) {
+    for (size_t i = 0; i < src->capacity; ++i) {
+        const Symbol *from = src->slots[i];
+        if (from == NULL) {
+            continue;
+        }
+        Symbol *to = symtab_lookup(dst, from->text, from->len, from->hash);
+        if (to == NULL) {
+            return false;
+        }
+        to->count += from->count;
+        if (from->first < to->first) to->first = from->first;
+        if (from->last > to->last) to->last = from->last;
+    }
+    return true;
+}
+
+/* Most frequent first; ties in name order so the output does not depend on thread timing. */
+static int compare_symbols(const void *a, const void *b) {
+    const Symbol *x = *(const Symbol *const *)a, *y = *(const Symbol *const *)b;
+    if (x->count != y->count) {
+        return x->count > y->count ? -1 : 1;
+    }
+    int c = memcmp(x->text, y->text, x->len < y->len ? x->len : y->len);
+    return c != 0 ? c : (x->len > y->len) - (x->len < y->len);
+}
+
+/* Fills out[0..n) with the n most frequent symbols; returns how many were written. */
+static size_t symtab_top(const SymbolTable *t, const Symbol **out, size_t n) {
+    const Symbol **all = malloc((t->used ? t->used : 1) * sizeof(*all));
+    if (all == NULL) {
+        return 0;
+    }
+    size_t k = 0;
+    for (size_t i = 0; i < t->capacity; ++i) {
+        if (t->slots[i] != NULL) {
+            all[k++] = t->slots[i];
+        }
+    }
+    qsort(all, k, sizeof(*all), compare_symbols);
+    if (n > k) n = k;
+    memcpy(out, all, n * sizeof(*out));
+    free(all);
+    return n;
+}
+
+/* Slots plus records; block headers and the unused tail of the newest block are left out. */
+static size_t symtab_bytes(const SymbolTable *t) {
+    return t->capacity * sizeof(Symbol *) + t->arena.used;
+}
+
+/* ---------- Per-file workers ---------- */
+
+typedef struct {
+    char *const *paths;
+    int path_count;
+    atomic_int *next_path;                                          /* Shared: next file to claim. */
+    SymbolTable table;                                              /* Private to this worker until the merge. */
+    unsigned long long identifiers;
+    int failed;
+} SymbolWorker;
+
+/* Identifier subscriber: one table, one file at a time. */
+typedef struct {
+    SymbolTable *table;
+    uint64_t file;                                                  /* Index into the path list, the position's high half. */
+    unsigned long long identifiers;
+    bool out_of_memory;                                             /* Stops inserting; the run still finishes. */
+} SymbolSink;
+
+static void add_identifier(const LexToken *tok, void *user) {
+    SymbolSink *sink = user;
+    if (sink->out_of_memory) {
+        return;
+    }
+    uint64_t line = tok->line > UINT32_MAX ? UINT32_MAX : tok->line;
+    if (!symtab_add(sink->table, tok->text, tok->len, (sink->file << 32) | line)) {
+        sink->out_of_memory = true;
+        return;
+    }
+    sink->identifiers++;
+}
+
+static void *symbol_worker(void *arg) {
+    SymbolWorker *w = arg;
+    int i;
+    while ((i = atomic_fetch_add(w->next_path, 1)) < w->path_count) {
+        SymbolSink sink = { &w->table, (uint64_t)i, 0, false };
+        LexSubscriber sub = { LEX_KIND_BIT(LEX_IDENTIFIER), add_identifier, &sink };
+        LexSummary summary;
+        if (lex_engine_run_file(w->paths[i], &sub, 1, &summary) != 0) { /* Errors are already reported. */
+            w->failed = 1;
+            continue;
+        }
+        w->identifiers += sink.identifiers;
+        if (sink.out_of_memory) {
+            fprintf(stderr, "Out of memory.\n");
+            w->failed = 1;
+            break;
+        }
+    }
+    return NULL;
+}
+
+static int run_symbols(char *const *paths, int path_count, int threads, size_t top) {
+    if (threads > path_count) threads = path_count;                 /* One file is never split between threads. */
+    SymbolWorker *workers = calloc((size_t)threads, sizeof(SymbolWorker));
+    pthread_t *tid = malloc((size_t)threads * sizeof(pthread_t));
+    int *started = calloc((size_t)threads, sizeof(int));
+    const Symbol **best = malloc((top ? top : 1) * sizeof(*best));
+    atomic_int next_path = 0;
+    int status = 0, ready = 0;
+    if (workers != NULL && tid != NULL && started != NULL && best != NULL) {
+        while (ready < threads && symtab_init(&workers[ready].table, 1024)) {
+            ready++;
+        }
+    }
+    if (ready < threads) {
+        fprintf(stderr, "Out of memory.\n");
+        while (ready > 0) symtab_free(&workers[--ready].table);
+        free(workers);
+        free(tid);
+        free(started);
+        free(best);
+        return 1;
+    }
+
+    double t0 = now_seconds();
+    for (int t = 0; t < threads; ++t) {
+        workers[t].paths = paths;
+        workers[t].path_count = path_count;
+        workers[t].next_path = &next_path;
+        started[t] = pthread_create(&tid[t], NULL, symbol_worker, &workers[t]) == 0;
+        if (!started[t]) {
+            symbol_worker(&workers[t]);                             /* Could not spawn: do it inline. */
+        }
+    }
+    for (int t = 0; t < threads; ++t) {
+        if (started[t]) pthread_join(tid[t], NULL);
+    }
+    double t1 = now_seconds();
+
+    SymbolTable *all = &workers[0].table;                           /* Everything is folded into the first table. */
+    unsigned long long identifiers = workers[0].identifiers;
+    status |= workers[0].failed;
+    for (int t = 1; t < threads; ++t) {
+        identifiers += workers[t].identifiers;
+        status |= workers[t].failed;
+        if (!symtab_merge(all, &workers[t].table)) {
+            fprintf(stderr, "Out of memory.\n");
+            status = 1;
+        }
+        symtab_free(&workers[t].table);
+    }
+    double t2 = now_seconds();
+
+    size_t n = symtab_top(all, best, top);
+    printf("%12s  %-32s %s\n", "Count", "Identifier", "First .. last occurrence");
+    for (size_t i = 0; i < n; ++i) {
+        const Symbol *s = best[i];
+        printf("%12llu  %-32.*s %s:%lu .. %s:%lu\n", (unsigned long long)s->count, (int)s->len, s->text,
+               paths[s->first >> 32], (unsigned long)(s->first & UINT32_MAX),
+               paths[s->last >> 32], (unsigned long)(s->last & UINT32_MAX));
+    }
+    fprintf(stderr, "%llu identifiers, %zu distinct, %.1f bytes per symbol; scan %.3f s, merge %.3f s (%d threads)\n",
+            identifiers, all->used, all->used ? (double)symtab_bytes(all) / (double)all->used : 0.0,
+            t1 - t0, t2 - t1, threads);
+
+    symtab_free(all);
+    free(workers);
+    free(tid);
+    free(started);
+    free(best);
+    return status;
+}
+
+/* ---------- Benchmark against a malloc-per-string table ---------- */
+
+/* The straightforward alternative: a chained hash with a malloc'd node and a strdup'd name per symbol. */
+typedef struct NaiveSymbol {
+    struct NaiveSymbol *next;
+    char *text;
+    uint64_t count, first, last;
+} NaiveSymbol;
+
+typedef struct {
+    NaiveSymbol **buckets;
+    size_t capacity, used;
+    size_t bytes;                                                   /* Requested bytes plus a 16-byte malloc header each. */
+} NaiveTable;
+
+#define MALLOC_OVERHEAD 16
+
+static bool naive_add(NaiveTable *t, const char *text, size_t len, uint64_t pos) {
+    uint32_t h = fnv1a(text, len);
+    NaiveSymbol *s;
+    for (s = t->buckets[h & (t->capacity - 1)]; s != NULL; s = s->next) {
+        if (strncmp(s->text, text, len) == 0 && s->text[len] == '\0') break;
+    }
+    if (s == NULL) {
+        if (t->used + 1 > t->capacity) {                            /* Rehash at load factor 1. */
+            size_t capacity = t->capacity * 2;
+            NaiveSymbol **buckets = calloc(capacity, sizeof(*buckets));
+            if (buckets == NULL) return false;
+            for (size_t i = 0; i < t->capacity; ++i) {
+                for (NaiveSymbol *e = t->buckets[i], *next; e != NULL; e = next) {
+                    next = e->next;
+                    size_t b = fnv1a(e->text, strlen(e->text)) & (capacity - 1);
+                    e->next = buckets[b];
+                    buckets[b] = e;
+                }
+            }
+            free(t->buckets);
+            t->buckets = buckets;
+            t->bytes += (capacity - t->capacity) * sizeof(*buckets);
+            t->capacity = capacity;
+        }
+        if ((s = malloc(sizeof(*s))) == NULL || (s->text = malloc(len + 1)) == NULL) {
+            free(s);
+            return false;
+        }
+        memcpy(s->text, text, len);
+        s->text[len] = '\0';
+        s->count = 0;
+        s->first = UINT64_MAX;
+        s->last = 0;
+        s->next = t->buckets[h & (t->capacity - 1)];
+        t->buckets[h & (t->capacity - 1)] = s;
+        t->used++;
+        t->bytes += sizeof(*s) + len + 1 + 2 * MALLOC_OVERHEAD;
+    }
+    s->count++;
+    if (pos < s->first) s->first = pos;
+    if (pos > s->last) s->last = pos;
+    return true;
+}
+
+static void naive_free(NaiveTable *t) {
+    for (size_t i = 0; i < t->capacity; ++i) {
+        for (NaiveSymbol *e = t->buckets[i], *next; e != NULL; e = next) {
+            next = e->next;
+            free(e->text);
+            free(e);
         }
-    } else {                                                        /* No filename provided, fall back to standard input. */
-        fp = stdin;                                                 /* stdin points to the console input stream. */
-        printf("Reading tokens from standard input (Ctrl+D to end)...\n"); /* Let the learner know how to finish input. */
     }
+    free(t->buckets);
+}
+
+typedef enum { TABLE_NONE, TABLE_ARENA, TABLE_NAIVE } TableKind;
+
+typedef struct {
+    TableKind kind;
+    SymbolTable *st;
+    NaiveTable *nt;
+    unsigned long long identifiers;
+    bool ok;
+} BenchSink;
+
+static void bench_identifier(const LexToken *tok, void *user) {
+    BenchSink *b = user;
+    if (!b->ok) return;
+    b->identifiers++;
+    if (b->kind == TABLE_ARENA) b->ok = symtab_add(b->st, tok->text, tok->len, tok->line);
+    else if (b->kind == TABLE_NAIVE) b->ok = naive_add(b->nt, tok->text, tok->len, tok->line);
+}
+
+/* Lexes path once, feeding identifiers to the chosen table. Returns seconds, or -1 on error. */
+static double time_symbol_pass(const char *path, TableKind kind, SymbolTable *st, NaiveTable *nt,
+                               unsigned long long *identifiers) {
+    BenchSink b = { kind, st, nt, 0, true };
+    LexSubscriber sub = { LEX_KIND_BIT(LEX_IDENTIFIER), bench_identifier, &b };
+    LexSummary summary;
+    double t0 = now_seconds();
+    if (lex_engine_run_file(path, &sub, 1, &summary) != 0) {
+        return -1;
+    }
+    double secs = now_seconds() - t0;
+    *identifiers = b.identifiers;
+    if (!b.ok) {
+        fprintf(stderr, "Out of memory.\n");
+        return -1;
+    }
+    return secs;
+}
+
+/* Same tokens three times: engine alone, then with each table; the difference is the insert cost. */
+static int run_symbol_bench(const char *path) {
+    SymbolTable st;
+    NaiveTable nt = { calloc(1024, sizeof(NaiveSymbol *)), 1024, 0, 1024 * sizeof(NaiveSymbol *) };
+    if (!symtab_init(&st, 1024) || nt.buckets == NULL) {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+    unsigned long long ids;
+    double base = time_symbol_pass(path, TABLE_NONE, NULL, NULL, &ids);
+    double arena = time_symbol_pass(path, TABLE_ARENA, &st, NULL, &ids);
+    double naive = time_symbol_pass(path, TABLE_NAIVE, NULL, &nt, &ids);
+    int status = (base < 0 || arena < 0 || naive < 0);
+    if (!status) {
+        double arena_ins = arena - base, naive_ins = naive - base;
+        printf("%llu identifier occurrences, %zu distinct; engine alone %.3f s\n", ids, st.used, base);
+        printf("arena + open addressing : %8.3f s %12.0f inserts/s %8.1f bytes/symbol\n", arena_ins,
+               arena_ins > 0 ? ids / arena_ins : 0.0, st.used ? (double)symtab_bytes(&st) / st.used : 0.0);
+        printf("malloc per string       : %8.3f s %12.0f inserts/s %8.1f bytes/symbol (approx.)\n", naive_ins,
+               naive_ins > 0 ? ids / naive_ins : 0.0, nt.used ? (double)nt.bytes / nt.used : 0.0);
+    }
+    symtab_free(&st);
+    naive_free(&nt);
+    return status;
+}
 
-    while (fscanf(fp, "%127s", word) != EOF) {                      /* Read whitespace-delimited tokens until EOF. */
-        if (is_keyword(word)) {                                     /* First check if the token is in the keyword list. */
-            printf("%-16s Keyword\n", word);                        /* %-16s left-aligns tokens for neat columns. */
-        } else if (isalpha((unsigned char)word[0]) || word[0] == '_') { /* Identifiers must start with letter or underscore. */
-            printf("%-16s Identifier\n", word);                     /* Report identifier classification. */
-        } else if (isdigit((unsigned char)word[0])) {               /* Tokens that start with a digit are numbers here. */
-            printf("%-16s Number\n", word);                         /* Report numeric classification. */
-        } else {                                                    /* Anything else is treated as an unknown symbol. */
-            printf("%-16s Unknown\n", word);                        /* Flag the token as unknown. */
+int main(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "--bench") == 0) {             /* Benchmark mode needs a real file. */
+        return run_bench(argv[2]);
+    }
+    if (argc == 3 && strcmp(argv[1], "--bench-symbols") == 0) {
+        return run_symbol_bench(argv[2]);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--symbols") == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        int threads = online > 0 ? (int)online : 1, top = 20, first = 2;
+        while (first + 1 < argc) {                                  /* Options, then one or more files. */
+            if (strcmp(argv[first], "--top") == 0) top = atoi(argv[first + 1]);
+            else if (strcmp(argv[first], "--threads") == 0) threads = atoi(argv[first + 1]);
+            else break;
+            first += 2;
         }
+        if (first >= argc || top < 0 || threads < 1) {
+            fprintf(stderr, "Usage: %s --symbols [--top N] [--threads T] <file>...\n", argv[0]);
+            return 1;
+        }
+        return run_symbols(argv + first, argc - first, threads, (size_t)top);
     }
 
-    if (fp != stdin) {                                              /* Only close the file if we actually opened one. */
-        fclose(fp);                                                 /* Release the file handle to avoid leaks. */
+    LexSubscriber sub = { TOKEN_KINDS, print_token, NULL };         /* Print every token as the engine emits it. */
+    LexSummary summary;
+    if (argc == 2) {                                                /* If a filename is provided, use it. */
+        return lex_engine_run_file(argv[1], &sub, 1, &summary) != 0; /* Errors are already reported. */
     }
-    return 0;                                                       /* Return success after processing the whole stream. */
+    printf("Reading tokens from standard input (Ctrl+D to end)...\n"); /* Let the learner know how to finish input. */
+    fflush(stdout);
+    return lex_engine_run_fd(STDIN_FILENO, "stdin", &sub, 1, &summary) != 0; /* The engine reads stdin to the end first. */
 }
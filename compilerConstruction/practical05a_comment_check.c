@@ -1,11 +1,193 @@
-#include <stdio.h>   /* Provides fgets, printf, fprintf. */
-#include <string.h>  /* Provides strlen and strcspn helpers. */
+#define _POSIX_C_SOURCE 200809L /* Expose clock_gettime and sched_yield. */
+
+#include <stdio.h>     /* Provides fgets, printf, fprintf. */
+#include <stdlib.h>    /* malloc / free. */
+#include <string.h>    /* strlen / strcspn / strcmp / memchr / memcpy / strerror. */
+#include <errno.h>     /* errno from a failed read or write. */
+#include <stdbool.h>   /* bool flags in the classifier state. */
+#include <time.h>      /* clock_gettime for the per-stage timing. */
+#include <fcntl.h>     /* open() for the stream input. */
+#include <unistd.h>    /* read / write / close. */
+#include <sched.h>     /* sched_yield while a ring is empty or full. */
+#include <pthread.h>   /* One thread per pipeline stage. */
+#include <stdatomic.h> /* Ring indices shared between two stages. */
 
 /*
- * Classifies a single line of text as a C style comment or not.
- * This is a direct translation of the manual exercise from the practical.
+ * Classifies lines of text as C style comments or not.
+ *
+ * Usage:
+ *   ./a.out                    classify one line typed at the prompt
+ *   ./a.out --stream [file|-]  classify every line of a file or stdin
+ *
+ * Build with -pthread.
+ *
+ * The prompt keeps the original rule: a line is a comment when its first two
+ * characters are // or slash-star, and a block comment closes on the line when
+ * its last two are star-slash.
+ *
+ * --stream classifies with LineScanner instead. It walks the stream byte by byte
+ * and remembers an open block comment from one line to the next, so lines
+ * between the opening and the closing marker are reported as part of the
+ * comment. Leading blanks are skipped, comment markers inside string and
+ * character literals are ignored, and no copy of a line is kept, so lines may be
+ * any length.
+ *
+ * The stream runs through a three-stage pipeline. A reader thread fills input blocks, a
+ * classifier thread turns them into one label per line, and a writer thread
+ * copies the labels to stdout. The stages pass block pointers through
+ * lock-free single-producer/single-consumer rings. Blocks come from two fixed
+ * pools, so memory stays bounded no matter how large the stream is. At the end
+ * every stage reports its throughput and every ring its occupancy on stderr;
+ * the busiest stage is the bottleneck.
  */
-int main(void) {
+
+typedef enum {
+    LINE_CODE,               /* Not a comment. */
+    LINE_SINGLE,             /* Starts with //. */
+    LINE_BLOCK_ONE_LINE,     /* Starts with slash-star and closes on the same line. */
+    LINE_BLOCK_START,        /* Starts with slash-star and stays open. */
+    LINE_BLOCK_INSIDE,       /* Entirely inside an open block comment. */
+    LINE_BLOCK_END,          /* Closes a block comment opened on an earlier line. */
+    LINE_CLASS_COUNT
+} LineClass;
+
+static const char *const line_messages[LINE_CLASS_COUNT] = {
+    "Not a comment.",
+    "Single-line comment.",
+    "Multi-line comment on a single line.",
+    "Start of a multi-line comment (unterminated on this line).",
+    "Inside a multi-line comment.",
+    "End of a multi-line comment."
+};
+
+static const char *const line_labels[LINE_CLASS_COUNT] = {
+    "code", "line-comment", "block-comment", "block-start", "block-body", "block-end"
+};
+
+typedef enum {
+    MODE_CODE,               /* Ordinary text. */
+    MODE_SLASH,              /* Saw '/' in code; a comment may start. */
+    MODE_STRING,             /* Inside "..."; escape says the last byte was a backslash. */
+    MODE_CHAR,               /* Inside '...'. */
+    MODE_LINE_COMMENT,       /* Rest of the line is a // comment. */
+    MODE_BLOCK,              /* Inside a block comment. */
+    MODE_BLOCK_STAR          /* Saw '*' inside a block comment; '/' closes it. */
+} ScanMode;
+
+typedef struct {
+    ScanMode mode;           /* Carries across lines only for block comments. */
+    bool escape;             /* Last literal byte was a backslash. */
+    bool leading;            /* Still in the blanks before the first visible byte. */
+    bool lead_slash;         /* The '/' in MODE_SLASH was that first visible byte. */
+    bool line_started;       /* The current line has at least one byte. */
+    LineClass cls;           /* Class of the current line so far. */
+} LineScanner;
+
+static void line_begin(LineScanner *ls) {
+    bool in_block = ls->mode == MODE_BLOCK || ls->mode == MODE_BLOCK_STAR;
+    ls->mode = in_block ? MODE_BLOCK : MODE_CODE;                   /* Everything but a block comment ends with the line. */
+    ls->cls = in_block ? LINE_BLOCK_INSIDE : LINE_CODE;
+    ls->escape = false;
+    ls->leading = !in_block;
+    ls->lead_slash = false;
+    ls->line_started = false;
+}
+
+static void scanner_init(LineScanner *ls) {
+    ls->mode = MODE_CODE;
+    line_begin(ls);
+}
+
+/*
+ * Feeds data[0..len) of the stream. Calls emit(cls, user) for every completed
+ * line, then starts the next one.
+ */
+static void classify_bytes(LineScanner *ls, const unsigned char *data, size_t len,
+                           void (*emit)(LineClass, void *), void *user) {
+    const unsigned char *p = data, *end = data + len;
+    while (p < end) {
+        unsigned char c = *p;
+        ls->line_started = true;
+        if (c == '\n') {
+            emit(ls->cls, user);
+            line_begin(ls);
+            p++;
+            continue;
+        }
+        if (ls->leading) {                                          /* Only the first visible byte decides "starts with". */
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+                p++;
+                continue;
+            }
+            ls->leading = false;
+            ls->lead_slash = (c == '/');
+        }
+
+        switch (ls->mode) {
+        case MODE_CODE:
+            if (c == '/') ls->mode = MODE_SLASH;
+            else if (c == '"') ls->mode = MODE_STRING;
+            else if (c == '\'') ls->mode = MODE_CHAR;
+            p++;
+            break;
+        case MODE_SLASH:
+            if (c == '/') {
+                ls->mode = MODE_LINE_COMMENT;
+                if (ls->lead_slash) ls->cls = LINE_SINGLE;
+                p++;
+            } else if (c == '*') {
+                ls->mode = MODE_BLOCK;
+                if (ls->lead_slash) ls->cls = LINE_BLOCK_START;
+                p++;
+            } else {
+                ls->mode = MODE_CODE;                               /* Re-read c as code: it may open a literal. */
+            }
+            ls->lead_slash = false;
+            break;
+        case MODE_STRING:
+        case MODE_CHAR:
+            if (ls->escape) ls->escape = false;
+            else if (c == '\\') ls->escape = true;
+            else if (c == (ls->mode == MODE_STRING ? '"' : '\'')) ls->mode = MODE_CODE;
+            p++;
+            break;
+        case MODE_LINE_COMMENT: {                                   /* Nothing matters until the newline. */
+            const unsigned char *nl = memchr(p, '\n', (size_t)(end - p));
+            p = nl ? nl : end;
+            break;
+        }
+        case MODE_BLOCK:
+            while (p < end && *p != '*' && *p != '\n') p++;         /* Skip comment text in bulk. */
+            if (p < end && *p == '*') {
+                ls->mode = MODE_BLOCK_STAR;
+                p++;
+            }
+            break;
+        case MODE_BLOCK_STAR:
+            if (c == '/') {
+                ls->mode = MODE_CODE;
+                if (ls->cls == LINE_BLOCK_START) ls->cls = LINE_BLOCK_ONE_LINE;
+                else if (ls->cls == LINE_BLOCK_INSIDE) ls->cls = LINE_BLOCK_END;
+            } else if (c != '*') {
+                ls->mode = MODE_BLOCK;
+            }
+            p++;
+            break;
+        }
+    }
+}
+
+/* Emits the last line if the stream did not end with a newline. */
+static void classify_finish(LineScanner *ls, void (*emit)(LineClass, void *), void *user) {
+    if (ls->line_started) {
+        emit(ls->cls, user);
+        line_begin(ls);
+    }
+}
+
+/* ---------- Interactive mode ---------- */
+
+static int run_interactive(void) {
     char line[256];                                               /* Buffer to hold one line of user input. */
 
     printf("Enter a line of code: ");                             /* Prompt the user for input. */
@@ -16,18 +198,271 @@ int main(void) {
 
     line[strcspn(line, "\n")] = '\0';                             /* Replace newline at end (if present) with terminator. */
 
+    LineClass cls = LINE_CODE;                                    /* Anything else is treated as regular source text. */
     if (line[0] == '/' && line[1] == '/') {                       /* Check if the line starts with // comment marker. */
-        printf("Single-line comment.\n");                         /* Output the classification result. */
+        cls = LINE_SINGLE;
     } else if (line[0] == '/' && line[1] == '*') {                /* Check if the line starts a block comment. */
         size_t len = strlen(line);                                /* Determine total length so we can inspect the end. */
         if (len >= 4 && line[len - 2] == '*' && line[len - 1] == '/') { /* Detect star-slash pair to see if comment closes here. */
-            printf("Multi-line comment on a single line.\n");      /* Detected complete block comment on one line. */
+            cls = LINE_BLOCK_ONE_LINE;                            /* Complete block comment on one line. */
         } else {
-            printf("Start of a multi-line comment (unterminated on this line).\n"); /* Comment continues on later lines. */
+            cls = LINE_BLOCK_START;                               /* Comment continues on later lines. */
         }
-    } else {                                                      /* Anything else is treated as regular source text. */
-        printf("Not a comment.\n");                              /* Inform the user that it is regular code. */
     }
-
+    printf("%s\n", line_messages[cls]);                           /* Output the classification result. */
     return 0;                                                     /* Return success after classification. */
 }
+
+/* ---------- Streaming pipeline ---------- */
+
+#define BLOCK_SIZE (1024 * 1024)
+#define POOL_BLOCKS 8              /* Blocks per pool; also the ring capacity, so returning a block never waits. */
+#define LABEL_MAX 16               /* Longest label plus newline. */
+
+typedef struct {
+    size_t len;                    /* Valid bytes in data. */
+    bool last;                     /* End of stream; data may still hold bytes. */
+    unsigned char data[BLOCK_SIZE];
+} Block;
+
+/*
+ * Single-producer/single-consumer ring of block pointers. Only the producer
+ * writes tail and only the consumer writes head, so an acquire load of the
+ * other side's index is all the synchronisation needed. The counters are kept
+ * on the side that updates them.
+ */
+typedef struct {
+    _Alignas(64) atomic_size_t head;          /* Consumer side. */
+    unsigned long long empty_waits;           /* Times the consumer found the ring empty. */
+    _Alignas(64) atomic_size_t tail;          /* Producer side. */
+    unsigned long long pushes;
+    unsigned long long occupancy_sum;         /* Blocks already queued, summed over pushes. */
+    size_t occupancy_max;
+    unsigned long long full_waits;            /* Times the producer found the ring full. */
+    _Alignas(64) Block *slots[POOL_BLOCKS];
+} Ring;
+
+static void ring_push(Ring *r, Block *b) {
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    size_t queued;
+    while ((queued = tail - atomic_load_explicit(&r->head, memory_order_acquire)) == POOL_BLOCKS) {
+        r->full_waits++;
+        sched_yield();
+    }
+    r->pushes++;
+    r->occupancy_sum += queued;
+    if (queued > r->occupancy_max) r->occupancy_max = queued;
+    r->slots[tail % POOL_BLOCKS] = b;
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+}
+
+static Block *ring_pop(Ring *r) {
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    while (atomic_load_explicit(&r->tail, memory_order_acquire) == head) {
+        r->empty_waits++;
+        sched_yield();
+    }
+    Block *b = r->slots[head % POOL_BLOCKS];
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    return b;
+}
+
+typedef struct {
+    double busy;                   /* Seconds spent working, waits excluded. */
+    unsigned long long bytes;      /* Bytes this stage consumed. */
+} StageStats;
+
+typedef struct {
+    int in_fd;
+    Ring in_free, in_full;         /* reader <-> classifier */
+    Ring out_free, out_full;       /* classifier <-> writer */
+    StageStats reader, classifier, writer;
+    unsigned long long lines[LINE_CLASS_COUNT];
+    int read_error, write_error;   /* errno of a failed read or write, else 0. */
+} Pipeline;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void *reader_stage(void *arg) {
+    Pipeline *pl = arg;
+    for (;;) {
+        Block *b = ring_pop(&pl->in_free);
+        double t0 = now_seconds();
+        b->len = 0;
+        b->last = false;
+        while (b->len < BLOCK_SIZE) {                               /* Fill the block; pipes return short reads. */
+            ssize_t n = read(pl->in_fd, b->data + b->len, BLOCK_SIZE - b->len);
+            if (n <= 0) {
+                pl->read_error = (n < 0) ? errno : 0;
+                b->last = true;
+                break;
+            }
+            b->len += (size_t)n;
+        }
+        pl->reader.bytes += b->len;
+        pl->reader.busy += now_seconds() - t0;
+        bool last = b->last;
+        ring_push(&pl->in_full, b);
+        if (last) return NULL;
+    }
+}
+
+typedef struct {
+    Pipeline *pl;
+    Block *out;                    /* Output block being filled. */
+} Emitter;
+
+static void emit_label(LineClass cls, void *user) {
+    Emitter *em = user;
+    if (BLOCK_SIZE - em->out->len < LABEL_MAX) {                    /* Full: hand it to the writer, take a fresh one. */
+        em->pl->classifier.busy += now_seconds();                   /* Waiting for a block is not work: */
+        ring_push(&em->pl->out_full, em->out);
+        em->out = ring_pop(&em->pl->out_free);
+        em->pl->classifier.busy -= now_seconds();                   /* the enclosing block timing adds it back. */
+        em->out->len = 0;
+        em->out->last = false;
+    }
+    size_t n = strlen(line_labels[cls]);
+    memcpy(em->out->data + em->out->len, line_labels[cls], n);
+    em->out->data[em->out->len + n] = '\n';
+    em->out->len += n + 1;
+    em->pl->lines[cls]++;
+}
+
+static void *classifier_stage(void *arg) {
+    Pipeline *pl = arg;
+    LineScanner ls;
+    scanner_init(&ls);
+    Emitter em = { pl, ring_pop(&pl->out_free) };
+    em.out->len = 0;
+    em.out->last = false;
+    for (;;) {
+        Block *in = ring_pop(&pl->in_full);
+        double t0 = now_seconds();
+        classify_bytes(&ls, in->data, in->len, emit_label, &em);
+        pl->classifier.bytes += in->len;
+        bool last = in->last;
+        if (last) {
+            classify_finish(&ls, emit_label, &em);
+        }
+        pl->classifier.busy += now_seconds() - t0;
+        ring_push(&pl->in_free, in);                                /* Input block is free for the reader again. */
+        if (last) {
+            em.out->last = true;
+            ring_push(&pl->out_full, em.out);
+            return NULL;
+        }
+    }
+}
+
+static void *writer_stage(void *arg) {
+    Pipeline *pl = arg;
+    for (;;) {
+        Block *b = ring_pop(&pl->out_full);
+        double t0 = now_seconds();
+        for (size_t done = 0; done < b->len && !pl->write_error; ) {
+            ssize_t n = write(STDOUT_FILENO, b->data + done, b->len - done);
+            if (n < 0) {
+                pl->write_error = errno;                            /* Keep draining so the classifier never blocks. */
+            } else {
+                done += (size_t)n;
+            }
+        }
+        pl->writer.bytes += b->len;
+        pl->writer.busy += now_seconds() - t0;
+        bool last = b->last;
+        ring_push(&pl->out_free, b);
+        if (last) return NULL;
+    }
+}
+
+static void report_stage(const char *name, const StageStats *s, double wall) {
+    double mb = (double)s->bytes / (1024.0 * 1024.0);
+    fprintf(stderr, "%-10s %12llu bytes %9.3f s busy (%5.1f%%) %10.1f MB/s\n", name, s->bytes, s->busy,
+            wall > 0 ? 100.0 * s->busy / wall : 0.0, s->busy > 0 ? mb / s->busy : 0.0);
+}
+
+static void report_ring(const char *name, const Ring *r) {
+    fprintf(stderr, "%-22s %8llu pushes, occupancy avg %.2f max %zu of %d, producer waits %llu, consumer waits %llu\n",
+            name, r->pushes, r->pushes ? (double)r->occupancy_sum / (double)r->pushes : 0.0,
+            r->occupancy_max, POOL_BLOCKS, r->full_waits, r->empty_waits);
+}
+
+static int run_stream(const char *path) {
+    static Pipeline pl;                                             /* Zeroed rings and counters. */
+    pl.in_fd = (path == NULL || strcmp(path, "-") == 0) ? STDIN_FILENO : open(path, O_RDONLY);
+    if (pl.in_fd < 0) {
+        perror(path);
+        return 1;
+    }
+    Block *pool = malloc(2 * POOL_BLOCKS * sizeof(Block));          /* The whole memory budget, allocated once. */
+    if (pool == NULL) {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+    for (int i = 0; i < POOL_BLOCKS; ++i) {
+        ring_push(&pl.in_free, &pool[i]);
+        ring_push(&pl.out_free, &pool[POOL_BLOCKS + i]);
+    }
+    pl.in_free.occupancy_max = pl.out_free.occupancy_max = 0;       /* Seeding the pools is not traffic. */
+    pl.in_free.pushes = pl.in_free.occupancy_sum = pl.out_free.pushes = pl.out_free.occupancy_sum = 0;
+
+    double t0 = now_seconds();
+    pthread_t tid[3];
+    void *(*stages[3])(void *) = { reader_stage, classifier_stage, writer_stage };
+    for (int i = 0; i < 3; ++i) {
+        if (pthread_create(&tid[i], NULL, stages[i], &pl) != 0) {
+            fprintf(stderr, "Unable to start the pipeline threads.\n");
+            exit(1);                                                /* Started stages would wait forever. */
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        pthread_join(tid[i], NULL);
+    }
+    double wall = now_seconds() - t0;
+
+    if (pl.in_fd != STDIN_FILENO) {
+        close(pl.in_fd);
+    }
+    free(pool);
+
+    unsigned long long total = 0;
+    for (int c = 0; c < LINE_CLASS_COUNT; ++c) {
+        total += pl.lines[c];
+    }
+    fprintf(stderr, "%llu lines:", total);
+    for (int c = 0; c < LINE_CLASS_COUNT; ++c) {
+        fprintf(stderr, " %s %llu%s", line_labels[c], pl.lines[c], c + 1 < LINE_CLASS_COUNT ? "," : "\n");
+    }
+    fprintf(stderr, "wall %.3f s, %.1f MB/s end to end\n", wall,
+            wall > 0 ? (double)pl.reader.bytes / (1024.0 * 1024.0) / wall : 0.0);
+    report_stage("reader", &pl.reader, wall);
+    report_stage("classifier", &pl.classifier, wall);
+    report_stage("writer", &pl.writer, wall);
+    report_ring("reader -> classifier", &pl.in_full);
+    report_ring("classifier -> writer", &pl.out_full);
+    const char *busiest = "reader";
+    double most = pl.reader.busy;
+    if (pl.classifier.busy > most) { busiest = "classifier"; most = pl.classifier.busy; }
+    if (pl.writer.busy > most) { busiest = "writer"; }
+    fprintf(stderr, "bottleneck: %s\n", busiest);
+
+    if (pl.read_error) fprintf(stderr, "read: %s\n", strerror(pl.read_error));
+    if (pl.write_error) fprintf(stderr, "write: %s\n", strerror(pl.write_error));
+    return pl.read_error != 0 || pl.write_error != 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && argc <= 3 && strcmp(argv[1], "--stream") == 0) {
+        return run_stream(argc == 3 ? argv[2] : NULL);
+    }
+    if (argc != 1) {
+        fprintf(stderr, "Usage: %s [--stream [file|-]]\n", argv[0]);
+        return 1;
+    }
+    return run_interactive();
+}
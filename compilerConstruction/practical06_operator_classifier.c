@@ -1,11 +1,30 @@
+#define _POSIX_C_SOURCE 200809L /* Expose clock_gettime. */
+
 #include <stdio.h>    /* Standard I/O functions such as printf and scanf. */
 #include <string.h>   /* strcmp lets us compare operator tokens. */
 #include <stdbool.h>  /* Provides the bool type for clarity. */
+#include <time.h>     /* clock_gettime for the benchmark. */
+#include "lexical_engine.h" /* The shared lexer the file modes are a front end for. */
 
 /*
  * Categorises an operator token into one of the common operator families found
  * in the C language. This mirrors what a lexical analyser would do before
  * emitting operator tokens.
+ *
+ * Usage:
+ *   ./a.out                    classify one operator typed at the prompt
+ *   ./a.out file.c             list every operator in the file with its position
+ *   ./a.out --counts file.c    per-family totals only
+ *   ./a.out --bench file.c     operators/sec of the engine table versus the strcmp chain
+ *
+ * File modes take the operator tokens of the shared lexer in lexical_engine.c,
+ * which splits by longest match, so "<<=" is one token rather than "<<" and "=".
+ * Comments and string/character literals are skipped, and identifiers and
+ * pp-numbers are whole tokens (the same stream practical04 lists), so the sign
+ * in 1e-5 or 0x1p+3 is part of the number, not an operator.
+ *
+ * Build with -pthread together with lexical_engine.c and its generated keyword
+ * table (see lexical_engine.h).
  */
 
 static bool is_arithmetic_operator(const char *op) {
@@ -37,7 +56,12 @@ static bool is_assignment_operator(const char *op) {
             !strcmp(op, "-=") ||  /* Subtraction assignment */
             !strcmp(op, "*=") ||  /* Multiplication assignment */
             !strcmp(op, "/=") ||  /* Division assignment */
-            !strcmp(op, "%="));   /* Modulus assignment */
+            !strcmp(op, "%=") ||  /* Modulus assignment */
+            !strcmp(op, "&=") ||  /* Bitwise AND assignment */
+            !strcmp(op, "|=") ||  /* Bitwise OR assignment */
+            !strcmp(op, "^=") ||  /* Bitwise XOR assignment */
+            !strcmp(op, "<<=") || /* Left shift assignment */
+            !strcmp(op, ">>="));  /* Right shift assignment */
 }
 
 static bool is_bitwise_operator(const char *op) {
@@ -49,7 +73,112 @@ static bool is_bitwise_operator(const char *op) {
             !strcmp(op, ">>"));   /* Right shift */
 }
 
-int main(void) {
+typedef enum {
+    FAMILY_NONE = LEX_OP_OTHER,         /* Operator outside the five families (++, --, ->). */
+    FAMILY_ARITHMETIC = LEX_OP_ARITHMETIC,
+    FAMILY_RELATIONAL = LEX_OP_RELATIONAL,
+    FAMILY_LOGICAL = LEX_OP_LOGICAL,
+    FAMILY_ASSIGNMENT = LEX_OP_ASSIGNMENT,
+    FAMILY_BITWISE = LEX_OP_BITWISE,
+    FAMILY_COUNT = LEX_OP_FAMILY_COUNT
+} OperatorFamily;
+
+/* The predicate chain used by the interactive mode, as a single family lookup. */
+static OperatorFamily classify_with_strcmp(const char *op) {
+    if (is_arithmetic_operator(op)) return FAMILY_ARITHMETIC;      /* Same order as the interactive report. */
+    if (is_relational_operator(op)) return FAMILY_RELATIONAL;
+    if (is_logical_operator(op)) return FAMILY_LOGICAL;
+    if (is_assignment_operator(op)) return FAMILY_ASSIGNMENT;
+    if (is_bitwise_operator(op)) return FAMILY_BITWISE;
+    return FAMILY_NONE;
+}
+
+typedef struct {
+    long long counts[FAMILY_COUNT];     /* Operators seen per family. */
+    long long total;                    /* All operators, including FAMILY_NONE. */
+    FILE *report;                       /* Per-operator listing, or NULL for counts only. */
+    bool use_strcmp;                    /* Benchmark: classify via the predicate chain instead of the token's family. */
+} OperatorCounter;
+
+/* Subscriber for the engine's operator tokens. */
+static void count_operator(const LexToken *tok, void *user) {
+    OperatorCounter *oc = user;
+    OperatorFamily family = (OperatorFamily)tok->family;
+    if (oc->use_strcmp) {
+        char op[4];                                                 /* Operators are at most 3 bytes. */
+        memcpy(op, tok->text, tok->len);
+        op[tok->len] = '\0';
+        family = classify_with_strcmp(op);
+    }
+    oc->counts[family]++;
+    oc->total++;
+    if (oc->report) {
+        fprintf(oc->report, "%llu:%llu\t%.*s\t%s\n", (unsigned long long)tok->line, (unsigned long long)tok->col,
+                (int)tok->len, tok->text, lex_family_name((LexOperatorFamily)family));
+    }
+}
+
+/* Runs the engine over a whole file, feeding its operators to oc. Returns 0 on success. */
+static int lex_file(const char *path, OperatorCounter *oc) {
+    LexSubscriber sub = { LEX_KIND_BIT(LEX_OPERATOR), count_operator, oc };
+    LexSummary summary;
+    return lex_engine_run_file(path, &sub, 1, &summary) != 0;      /* Errors are already reported. */
+}
+
+static void print_counts(const OperatorCounter *oc) {
+    for (int f = FAMILY_ARITHMETIC; f < FAMILY_COUNT; ++f) {
+        printf("%-10s : %lld\n", lex_family_name((LexOperatorFamily)f), oc->counts[f]);
+    }
+    printf("%-10s : %lld\n", lex_family_name(LEX_OP_OTHER), oc->counts[FAMILY_NONE]);
+    printf("%-10s : %lld\n", "Total", oc->total);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Same file, same tokens; only the classification step differs. */
+static int run_bench(const char *path) {
+    OperatorCounter table = { { 0 }, 0, NULL, false };
+    OperatorCounter chain = { { 0 }, 0, NULL, true };
+
+    double t0 = now_seconds();
+    if (lex_file(path, &chain) != 0) return 1;
+    double t1 = now_seconds();
+    if (lex_file(path, &table) != 0) return 1;
+    double t2 = now_seconds();
+
+    bool agree = memcmp(table.counts, chain.counts, sizeof(table.counts)) == 0;
+    printf("strcmp chain : %12lld operators %8.3f s %12.0f operators/s\n",
+           chain.total, t1 - t0, (t1 > t0) ? chain.total / (t1 - t0) : 0.0);
+    printf("engine table : %12lld operators %8.3f s %12.0f operators/s\n",
+           table.total, t2 - t1, (t2 > t1) ? table.total / (t2 - t1) : 0.0);
+    printf("family counts %s\n", agree ? "agree" : "DIFFER");
+    return agree ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {                                                 /* File modes. */
+        if (argc == 3 && strcmp(argv[1], "--bench") == 0) {
+            return run_bench(argv[2]);
+        }
+        OperatorCounter oc = { { 0 }, 0, NULL, false };
+        if (argc == 3 && strcmp(argv[1], "--counts") == 0) {
+            if (lex_file(argv[2], &oc) != 0) return 1;
+        } else if (argc == 2 && strncmp(argv[1], "--", 2) != 0) {
+            oc.report = stdout;
+            if (lex_file(argv[1], &oc) != 0) return 1;
+            printf("\n");
+        } else {
+            fprintf(stderr, "Usage: %s [[--counts | --bench] <source-file>]\n", argv[0]);
+            return 1;
+        }
+        print_counts(&oc);
+        return 0;
+    }
+
     char op[8];                                                     /* Buffer to hold the operator token from input. */
 
     printf("Enter an operator: ");                                  /* Prompt the learner for an operator. */
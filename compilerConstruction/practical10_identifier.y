@@ -1,15 +1,48 @@
 %{ /* ---------- C prologue ---------- */
+#define _POSIX_C_SOURCE 200809L /* Expose clock_gettime and sysconf. */
 #include <stdio.h>       /* printf prototype used in actions and main. */
+#include <stdlib.h>      /* malloc / free / atoi. */
+#include <string.h>      /* strcmp / memchr. */
+#include <limits.h>      /* INT_MAX, the longest line yy_scan_bytes accepts. */
+#include <time.h>        /* clock_gettime for the scaling report. */
+#include <fcntl.h>       /* open() for the batch input. */
+#include <unistd.h>      /* close(), sysconf(). */
+#include <pthread.h>     /* Worker threads for batch validation. */
+#include <sys/mman.h>    /* mmap for the batch input. */
+#include <sys/stat.h>    /* fstat for the input size. */
+%}
 
 /*
- * Global flag that becomes 0 once the parser encounters an invalid identifier
- * structure. The parser accepts if the input starts with a letter and is
- * followed by letters or digits only.
+ * Pure parser: no globals. The scanner handle and an IdentContext travel
+ * through yyparse into yylex and yyerror, so one parser/scanner pair per
+ * thread can run concurrently. Requires Bison and a Flex scanner generated
+ * with %option reentrant bison-bridge (see practical10_identifier.l).
  */
-static int valid = 1;    /* Assume success unless yyerror marks it invalid. */
-%}
+%define api.pure full
+%lex-param   { yyscan_t scanner }
+%parse-param { yyscan_t scanner } { IdentContext *ctx }
+
+%code requires {
+typedef void *yyscan_t;   /* Opaque Flex scanner handle. */
+
+/*
+ * Per-parse state. valid becomes 0 once the parser encounters an invalid
+ * identifier structure. The parser accepts if the input starts with a letter
+ * and is followed by letters or digits only.
+ */
+typedef struct IdentContext {
+    int valid;            /* Assume success unless yyerror marks it invalid. */
+    int quiet;            /* Batch mode: record the verdict without printing. */
+} IdentContext;
+}
+
+%code provides {
+int yylex(YYSTYPE *lvalp, yyscan_t scanner);
+int yyerror(yyscan_t scanner, IdentContext *ctx, const char *msg);
+}
 
 %token digit letter      /* Tokens supplied by the scanner (Flex). */
+%token invalid           /* A byte no identifier may contain (NUL); no rule accepts it. */
 
 %% /* ---------- Grammar rules ---------- */
 start : letter sequence  /* Valid identifier must start with a letter token. */
@@ -21,18 +54,231 @@ sequence : letter sequence  /* Zero or more additional letters keep it valid. */
          ;
 %%
 
-int yyerror(const char *unused) {
+/* Reentrant Flex entry points (declared here because the parser does not include the scanner header). */
+typedef struct yy_buffer_state *YY_BUFFER_STATE;
+int yylex_init(yyscan_t *scanner);
+int yylex_destroy(yyscan_t scanner);
+void yyset_in(FILE *in, yyscan_t scanner);
+YY_BUFFER_STATE yy_scan_bytes(const char *bytes, int len, yyscan_t scanner);
+void yy_delete_buffer(YY_BUFFER_STATE buffer, yyscan_t scanner);
+void scanner_instrument_init(void);
+void scanner_instrument_flush(void);
+
+int yyerror(yyscan_t scanner, IdentContext *ctx, const char *unused) {
+    (void)scanner;                        /* The handle is only part of the pure signature. */
     (void)unused;                         /* Avoid unused parameter warning. */
-    printf("\nIt's not an identifier!\n");/* Feedback for invalid input. */
-    valid = 0;                            /* Mark the input as invalid. */
+    if (!ctx->quiet) {
+        printf("\nIt's not an identifier!\n");/* Feedback for invalid input. */
+    }
+    ctx->valid = 0;                       /* Mark the input as invalid. */
     return 0;                             /* Returning 0 keeps parser running gracefully. */
 }
 
-int main(void) {
+/*
+ * Batch driver: every line of the input is one candidate. Lines are split into
+ * contiguous ranges, one per worker; each worker owns its scanner and context
+ * and writes verdicts only into its own slice of the result array, so no
+ * mutable state is shared and the verdicts come out in input order. At most
+ * MAX_THREADS workers run; the per-worker arrays live on the stack. A line
+ * longer than INT_MAX bytes, more than yy_scan_bytes can take, is rejected
+ * without scanning.
+ */
+#define MAX_THREADS 256
+typedef struct {
+    const char *data;         /* Mapped input. */
+    const size_t *starts;     /* Line i spans starts[i] .. starts[i + 1] - 1 (newline excluded). */
+    size_t first, last;       /* Lines [first, last) belong to this worker. */
+    unsigned char *verdicts;  /* Shared array; each worker touches only its own range. */
+    int failed;               /* Scanner could not be created. */
+    size_t too_long;          /* Lines rejected unscanned because yy_scan_bytes takes an int length. */
+} BatchSlice;
+
+static void *batch_worker(void *arg) {
+    BatchSlice *s = arg;
+    yyscan_t scanner;
+    if (yylex_init(&scanner) != 0) {
+        s->failed = 1;
+        return NULL;
+    }
+    for (size_t i = s->first; i < s->last; ++i) {
+        size_t begin = s->starts[i];
+        size_t end = s->starts[i + 1] - 1;                          /* Drop the newline; the scanner sees EOF instead. */
+        if (end - begin > (size_t)INT_MAX) {
+            s->verdicts[i] = 0;
+            s->too_long++;
+            continue;
+        }
+        IdentContext ctx = { 1, 1 };
+        YY_BUFFER_STATE buf = yy_scan_bytes(s->data + begin, (int)(end - begin), scanner);
+        int rc = yyparse(scanner, &ctx);
+        yy_delete_buffer(buf, scanner);
+        s->verdicts[i] = (unsigned char)(rc == 0 && ctx.valid);
+    }
+    yylex_destroy(scanner);
+    scanner_instrument_flush();                                     /* Rule counts are per thread until merged. */
+    return NULL;
+}
+
+/* Validates every line with the given number of threads. Returns 0 on success. */
+static int validate_lines(const char *data, const size_t *starts, size_t lines,
+                          unsigned char *verdicts, int threads, size_t *too_long) {
+    BatchSlice slices[threads];
+    pthread_t tid[threads];
+    int started[threads];
+    int status = 0;
+
+    for (int t = 0; t < threads; ++t) {
+        slices[t] = (BatchSlice){ data, starts, lines * (size_t)t / (size_t)threads,
+                                  lines * (size_t)(t + 1) / (size_t)threads, verdicts, 0, 0 };
+        started[t] = pthread_create(&tid[t], NULL, batch_worker, &slices[t]) == 0;
+        if (!started[t]) {
+            batch_worker(&slices[t]);                               /* Could not spawn: do it inline. */
+        }
+    }
+    for (int t = 0; t < threads; ++t) {
+        if (started[t]) pthread_join(tid[t], NULL);
+        status |= slices[t].failed;
+        *too_long += slices[t].too_long;
+    }
+    return status;
+}
+
+/*
+ * Maps path and records where every line starts. starts gets lines + 1
+ * entries; the sentinel is one past the end as if a final newline existed.
+ */
+static int load_lines(const char *path, const char **data, size_t *len, size_t **starts, size_t *lines) {
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    *len = (size_t)st.st_size;
+    void *m = mmap(NULL, *len ? *len : 1, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+    *data = m;
+
+    size_t count = 0, cap = 1024;
+    size_t *s = malloc(cap * sizeof(size_t));
+    const char *p = *data, *end = *data + *len;
+    while (s != NULL && p < end) {
+        if (count + 2 > cap) {
+            size_t *grown = realloc(s, (cap *= 2) * sizeof(size_t));
+            if (grown == NULL) {
+                free(s);
+                s = NULL;
+                break;
+            }
+            s = grown;
+        }
+        s[count++] = (size_t)(p - *data);
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        p = nl ? nl + 1 : end;
+    }
+    if (s == NULL) {
+        fprintf(stderr, "Out of memory.\n");
+        munmap(m, *len ? *len : 1);
+        return -1;
+    }
+    s[count] = (*len > 0 && (*data)[*len - 1] == '\n') ? *len : *len + 1;
+    *starts = s;
+    *lines = count;
+    return 0;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int run_batch(const char *path, int threads, int bench) {
+    const char *data;
+    size_t len, *starts, lines;
+    if (load_lines(path, &data, &len, &starts, &lines) != 0) {
+        return 1;
+    }
+    unsigned char *verdicts = malloc(lines ? lines : 1);
+    if (verdicts == NULL) {
+        fprintf(stderr, "Out of memory.\n");
+        free(starts);
+        munmap((void *)data, len ? len : 1);
+        return 1;
+    }
+
+    int status = 0;
+    size_t too_long = 0;
+    if (bench) {                                                    /* Same lines, doubling thread counts up to the limit. */
+        double base = 0.0;
+        for (int t = 1; t <= threads; t = (t * 2 > threads && t != threads) ? threads : t * 2) {
+            double t0 = now_seconds();
+            status |= validate_lines(data, starts, lines, verdicts, t, &too_long);
+            double secs = now_seconds() - t0;
+            double rate = (secs > 0) ? (double)lines / secs : 0.0;
+            if (t == 1) base = rate;
+            printf("%3d threads : %10.3f s %12.0f lines/s  x%.2f\n", t, secs, rate, base > 0 ? rate / base : 0.0);
+        }
+    } else {
+        status = validate_lines(data, starts, lines, verdicts, threads, &too_long);
+        size_t valid = 0;
+        for (size_t i = 0; i < lines; ++i) {                        /* Verdicts are already in input order. */
+            putchar('0' + verdicts[i]);
+            putchar('\n');
+            valid += verdicts[i];
+        }
+        fprintf(stderr, "%zu of %zu lines are valid identifiers.\n", valid, lines);
+    }
+    if (status != 0) {
+        fprintf(stderr, "Unable to create a scanner.\n");
+    }
+    if (too_long > 0 && !bench) {
+        fprintf(stderr, "%zu lines longer than %d bytes were rejected without scanning.\n", too_long, INT_MAX);
+    }
+
+    free(verdicts);
+    free(starts);
+    munmap((void *)data, len ? len : 1);
+    return status;
+}
+
+int main(int argc, char **argv) {
+    scanner_instrument_init();
+    if (argc >= 3 && argc <= 4 && (strcmp(argv[1], "--batch") == 0 || strcmp(argv[1], "--bench") == 0)) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        int threads = (argc == 4) ? atoi(argv[3]) : (online > 0 ? (int)online : 1);
+        if (threads < 1) {
+            fprintf(stderr, "Thread count must be positive.\n");
+            return 1;
+        }
+        if (threads > MAX_THREADS) {
+            threads = MAX_THREADS;
+        }
+        return run_batch(argv[2], threads, strcmp(argv[1], "--bench") == 0);
+    }
+    if (argc != 1) {
+        fprintf(stderr, "Usage: %s [--batch | --bench] <candidates-file> [threads]\n", argv[0]);
+        return 1;
+    }
+
+    yyscan_t scanner;                                /* Private scanner reading the prompt line. */
+    IdentContext ctx = { 1, 0 };                     /* Valid until yyerror says otherwise; messages on. */
+    if (yylex_init(&scanner) != 0) {
+        fprintf(stderr, "Unable to create a scanner.\n");
+        return 1;
+    }
+    yyset_in(stdin, scanner);
+
     printf("Enter a name to test for identifier: "); /* Prompt the learner. */
-    yyparse();                                       /* Start parsing tokens from the scanner. */
-    if (valid) {                                     /* Only print success message if no errors occurred. */
+    yyparse(scanner, &ctx);                          /* Start parsing tokens from the scanner. */
+    if (ctx.valid) {                                 /* Only print success message if no errors occurred. */
         printf("\nIt is a valid identifier!\n");
     }
+    yylex_destroy(scanner);
     return 0;                                       /* Exit cleanly. */
 }
@@ -0,0 +1,157 @@
+#define _POSIX_C_SOURCE 200809L /* Expose clock_gettime. */
+
+#include <stdio.h>    /* printf / fprintf / fopen. */
+#include <string.h>   /* strcmp. */
+#include <stdbool.h>  /* bool flags. */
+#include <time.h>     /* clock_gettime for the timing line. */
+
+#include "lexical_engine.h"
+
+/*
+ * One pass, several analyses. Each option below subscribes one consumer to the
+ * shared lexer in lexical_engine.c, so asking for all of them still reads and
+ * lexes the file once.
+ *
+ * Usage:
+ *   ./a.out [options] file.c
+ *     --strip <out>   write the file without comments; same bytes as practical03c
+ *     --tokens        list keywords, identifiers, numbers, ... as practical04 does
+ *     --operators     list operators as line:col, text, family; same as practical06
+ *     --numbers       list pp-numbers outside comments and literals (practical03a's
+ *                     patterns are stricter and also match inside them)
+ *     --time          report elapsed time and throughput on stderr
+ *   With no listing option only the summary is printed: comment lines (as
+ *   practical03c counts them), token and operator-family counts, and
+ *   Lines/Words/Characters (as practical02d counts them).
+ *
+ * Build: gcc -pthread practical11_unified_analysis.c lexical_engine.c, after
+ * generating lex_keyword_table.h (see lexical_engine.h).
+ */
+
+/* ---------- Subscribers ---------- */
+
+/* Copies every token except comments; a block comment leaves only its newlines behind, as in practical03c. */
+static void strip_token(const LexToken *tok, void *user) {
+    FILE *out = user;
+    if (tok->kind != LEX_COMMENT) {
+        fwrite(tok->text, 1, tok->len, out);
+        return;
+    }
+    for (uint64_t i = 1; i < tok->comment_lines; ++i) {
+        putc('\n', out);
+    }
+}
+
+/* practical04 has no operator kind: operators are listed as the punctuators they are. */
+static void list_token(const LexToken *tok, void *user) {
+    (void)user;
+    LexKind kind = (tok->kind == LEX_OPERATOR) ? LEX_PUNCTUATOR : tok->kind;
+    printf("%-16.*s %s\n", (int)tok->len, tok->text, lex_kind_name(kind));
+}
+
+static void list_operator(const LexToken *tok, void *user) {
+    (void)user;
+    printf("%llu:%llu\t%.*s\t%s\n", (unsigned long long)tok->line, (unsigned long long)tok->col,
+           (int)tok->len, tok->text, lex_family_name(tok->family));
+}
+
+static void list_number(const LexToken *tok, void *user) {
+    (void)user;
+    printf("NUMBER: %.*s\n", (int)tok->len, tok->text);
+}
+
+/* ---------- Driver ---------- */
+
+static void print_summary(const LexSummary *s) {
+    printf("Total comment lines : %llu\n", (unsigned long long)s->comment_lines);
+    for (int k = LEX_COMMENT; k < LEX_KIND_COUNT; ++k) {
+        printf("%-10s : %llu\n", lex_kind_name((LexKind)k), (unsigned long long)s->tokens[k]);
+    }
+    for (int f = LEX_OP_ARITHMETIC; f < LEX_OP_FAMILY_COUNT; ++f) {
+        printf("  %-10s : %llu\n", lex_family_name((LexOperatorFamily)f), (unsigned long long)s->operators[f]);
+    }
+    printf("  %-10s : %llu\n", lex_family_name(LEX_OP_OTHER), (unsigned long long)s->operators[LEX_OP_OTHER]);
+    printf("\nLines : %llu\nWords : %llu\nCharacters : %llu\n",
+           (unsigned long long)s->lines, (unsigned long long)s->words, (unsigned long long)s->chars);
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--strip <out>] [--tokens] [--operators] [--numbers] [--time] <file>\n", prog);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    LexSubscriber subs[4];
+    size_t count = 0;
+    const char *strip_path = NULL, *input = NULL;
+    bool tokens = false, operators = false, numbers = false, timing = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--strip") == 0 && i + 1 < argc) {
+            strip_path = argv[++i];
+        } else if (strcmp(argv[i], "--tokens") == 0) {
+            tokens = true;
+        } else if (strcmp(argv[i], "--operators") == 0) {
+            operators = true;
+        } else if (strcmp(argv[i], "--numbers") == 0) {
+            numbers = true;
+        } else if (strcmp(argv[i], "--time") == 0) {
+            timing = true;
+        } else if (argv[i][0] == '-' || input != NULL) {
+            return usage(argv[0]);
+        } else {
+            input = argv[i];
+        }
+    }
+    if (input == NULL) {
+        return usage(argv[0]);
+    }
+
+    FILE *strip_out = NULL;
+    if (strip_path != NULL) {
+        strip_out = fopen(strip_path, "w");
+        if (strip_out == NULL) {
+            perror(strip_path);
+            return 1;
+        }
+        setvbuf(strip_out, NULL, _IOFBF, 1 << 20);
+        subs[count++] = (LexSubscriber){ LEX_ALL_KINDS, strip_token, strip_out };
+    }
+    if (tokens) {
+        subs[count++] = (LexSubscriber){ LEX_ALL_KINDS & ~(LEX_KIND_BIT(LEX_SPACE) | LEX_KIND_BIT(LEX_COMMENT)),
+                                         list_token, NULL };
+    }
+    if (operators) {
+        subs[count++] = (LexSubscriber){ LEX_KIND_BIT(LEX_OPERATOR), list_operator, NULL };
+    }
+    if (numbers) {
+        subs[count++] = (LexSubscriber){ LEX_KIND_BIT(LEX_NUMBER), list_number, NULL };
+    }
+
+    LexSummary summary;
+    double t0 = now_seconds();
+    int status = lex_engine_run_file(input, subs, count, &summary);
+    double secs = now_seconds() - t0;
+
+    if (strip_out != NULL && fclose(strip_out) != 0) {
+        perror(strip_path);
+        status = -1;
+    }
+    if (status != 0) {
+        return 1;
+    }
+    if (count == 0 || strip_path != NULL) {
+        print_summary(&summary);
+    }
+    if (timing) {
+        double mb = (double)summary.chars / (1024.0 * 1024.0);
+        fprintf(stderr, "%.1f MB in %.3f s, %.1f MB/s\n", mb, secs, secs > 0 ? mb / secs : 0.0);
+    }
+    return 0;
+}
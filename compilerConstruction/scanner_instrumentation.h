@@ -0,0 +1,298 @@
+#ifndef SCANNER_INSTRUMENTATION_H
+#define SCANNER_INSTRUMENTATION_H
+
+/*
+ * Optional hot-path counters for the scanners. Compile with -DSCANNER_INSTRUMENT
+ * to turn them on; without it every macro below expands to nothing, so the
+ * instrumented code is byte-for-byte the uninstrumented code.
+ *
+ *   SI_INIT(tool, state_names, state_count, rule_names, rule_count)
+ *                            once in main; dumps JSON at exit and arms SIGUSR1
+ *   SI_RUN_BEGIN(r) / SI_RUN_STEP(r, s, n) / SI_RUN_END(r)
+ *                            byte-at-a-time loops: n bytes handled in state s;
+ *                            the current run stays in a local until s changes
+ *   SI_SPAN(s, n)            n bytes handled in state s in one step (skipping loops)
+ *   SI_RULE(r, n)            Flex rule r (yy_act, 1-based) matched n bytes; meant
+ *                            for YY_USER_ACTION
+ *   SI_BYTES(n)              n input bytes processed (scanners without SI_RULE)
+ *   SI_TIME_BEGIN(t) / SI_TIME_END(t, SI_IO or SI_SCAN)
+ *                            attribute the time in between to I/O or scanning;
+ *                            I/O timed inside a scan section (a YY_INPUT
+ *                            refill, say) is not counted again as scan time
+ *   SI_SUSPEND(v) / SI_RESUME(v)
+ *                            drop whatever is counted in between (speculative
+ *                            scans that may be thrown away); no snapshot is
+ *                            taken in between
+ *   SI_THREAD_FLUSH()        fold this thread's counters into the totals; call
+ *                            before a worker thread exits
+ *
+ * A run is a maximal stretch of consecutive bytes in one state; transitions
+ * count state changes only, and avg_run = bytes / runs. States with a large
+ * share of the bytes and long runs are where a vectorised skip pays off; the
+ * JSON lists them under "vectorize_candidates".
+ *
+ * Counters live in thread-local storage, so workers never contend. SIGUSR1 only
+ * sets a flag; the next state change or rule hit outside a suspended section
+ * writes a snapshot holding the flushed threads plus the thread that noticed
+ * the flag. All of this state is
+ * per translation unit, so a scanner's hooks and its SI_INIT belong in one file.
+ *
+ * The JSON goes to $SCANNER_INSTRUMENT_OUT, to stderr when that is "-", and to
+ * <tool>.instrument.json in the working directory when it is unset.
+ */
+
+#ifdef SCANNER_INSTRUMENT
+
+#include <stdio.h>     /* JSON output. */
+#include <stdlib.h>    /* atexit / getenv. */
+#include <string.h>    /* memset. */
+#include <signal.h>    /* SIGUSR1 snapshot request. */
+#include <time.h>      /* timespec_get for the I/O and scan timers (C11, no POSIX macros needed). */
+#include <pthread.h>   /* Mutex around the shared totals. */
+
+#define SI_MAX_STATES 16
+#define SI_MAX_RULES 64                 /* Rules beyond this are pooled in the last slot. */
+#define SI_VECTOR_MIN_RUN 16.0          /* One SSE2 register: shorter runs gain little from SIMD. */
+
+enum { SI_IO, SI_SCAN };
+
+typedef struct {
+    unsigned long long state_bytes[SI_MAX_STATES];
+    unsigned long long state_runs[SI_MAX_STATES];
+    unsigned long long transitions[SI_MAX_STATES][SI_MAX_STATES];
+    unsigned long long rule_hits[SI_MAX_RULES];
+    unsigned long long rule_bytes[SI_MAX_RULES];
+    unsigned long long bytes;
+    double seconds[2];                  /* SI_IO, SI_SCAN. */
+    int prev_state;                     /* -1 until the first byte; per thread. */
+} SiCounters;
+
+static _Thread_local SiCounters si_local = { .prev_state = -1 };
+static _Thread_local double si_io_clock;    /* All I/O time of this thread; never reset, unlike si_local. */
+static _Thread_local int si_suspended;      /* SI_SUSPEND depth; si_local holds speculative counts while > 0. */
+static SiCounters si_total;
+static pthread_mutex_t si_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile sig_atomic_t si_snapshot_requested;
+
+static struct {
+    const char *tool;
+    const char *const *state_names;
+    int state_count;
+    const char *const *rule_names;
+    int rule_count;
+} si_meta;
+
+static inline void si_write_json(int final);
+
+static inline void si_state(int s, unsigned long long n) {
+    si_local.state_bytes[s] += n;
+    if (s != si_local.prev_state) {
+        si_local.state_runs[s]++;
+        if (si_local.prev_state >= 0) {
+            si_local.transitions[si_local.prev_state][s]++;
+        }
+        si_local.prev_state = s;
+        if (si_snapshot_requested && !si_suspended) {
+            si_snapshot_requested = 0;
+            si_write_json(0);
+        }
+    }
+}
+
+static inline void si_rule(int r, unsigned long long n) {
+    r = (r < 1) ? 0 : (r > SI_MAX_RULES ? SI_MAX_RULES - 1 : r - 1);
+    si_local.rule_hits[r]++;
+    si_local.rule_bytes[r] += n;
+    si_local.bytes += n;
+    if (si_snapshot_requested && !si_suspended) {
+        si_snapshot_requested = 0;
+        si_write_json(0);
+    }
+}
+
+typedef struct {
+    double start;                           /* Wall clock at SI_TIME_BEGIN. */
+    double io;                              /* si_io_clock at SI_TIME_BEGIN. */
+} SiTimer;
+
+static inline double si_now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static inline SiTimer si_timer_begin(void) {
+    SiTimer t = { si_now(), si_io_clock };
+    return t;
+}
+
+static inline void si_timer_end(SiTimer t, int kind) {
+    double nested_io = si_io_clock - t.io;
+    double exclusive = si_now() - t.start - nested_io;
+    si_local.seconds[kind] += exclusive;
+    if (kind == SI_IO) {
+        si_io_clock += exclusive;
+    }
+}
+
+static inline SiCounters si_suspend(void) {
+    si_suspended++;
+    return si_local;
+}
+
+static inline void si_resume(const SiCounters *saved) {
+    si_local = *saved;
+    si_suspended--;
+}
+
+static inline void si_flush(void) {
+    pthread_mutex_lock(&si_lock);
+    for (int i = 0; i < SI_MAX_STATES; ++i) {
+        si_total.state_bytes[i] += si_local.state_bytes[i];
+        si_total.state_runs[i] += si_local.state_runs[i];
+        for (int j = 0; j < SI_MAX_STATES; ++j) {
+            si_total.transitions[i][j] += si_local.transitions[i][j];
+        }
+    }
+    for (int i = 0; i < SI_MAX_RULES; ++i) {
+        si_total.rule_hits[i] += si_local.rule_hits[i];
+        si_total.rule_bytes[i] += si_local.rule_bytes[i];
+    }
+    si_total.bytes += si_local.bytes;
+    si_total.seconds[SI_IO] += si_local.seconds[SI_IO];
+    si_total.seconds[SI_SCAN] += si_local.seconds[SI_SCAN];
+    pthread_mutex_unlock(&si_lock);
+    int prev = si_local.prev_state;                                 /* A snapshot must not split the current run. */
+    memset(&si_local, 0, sizeof(si_local));
+    si_local.prev_state = prev;
+}
+
+static inline void si_write_json(int final) {
+    si_flush();
+    const char *path = getenv("SCANNER_INSTRUMENT_OUT");
+    char fallback[256];
+    if (path == NULL) {
+        snprintf(fallback, sizeof(fallback), "%s.instrument.json", si_meta.tool);
+        path = fallback;
+    }
+    FILE *fp = (strcmp(path, "-") == 0) ? stderr : fopen(path, "w");
+    if (fp == NULL) {
+        perror(path);
+        return;
+    }
+
+    pthread_mutex_lock(&si_lock);                                   /* Other threads may be flushing. */
+    SiCounters copy = si_total;
+    pthread_mutex_unlock(&si_lock);
+    const SiCounters *c = &copy;
+    unsigned long long state_sum = 0;
+    for (int s = 0; s < si_meta.state_count; ++s) {
+        state_sum += c->state_bytes[s];
+    }
+    fprintf(fp, "{\n  \"tool\": \"%s\",\n  \"final\": %s,\n  \"bytes\": %llu,\n", si_meta.tool,
+            final ? "true" : "false", c->bytes);
+    fprintf(fp, "  \"seconds\": { \"io\": %.6f, \"scan\": %.6f },\n", c->seconds[SI_IO], c->seconds[SI_SCAN]);
+
+    fprintf(fp, "  \"states\": [");
+    for (int s = 0; s < si_meta.state_count; ++s) {
+        fprintf(fp, "%s\n    { \"name\": \"%s\", \"bytes\": %llu, \"share\": %.4f, \"runs\": %llu, \"avg_run\": %.2f }",
+                s ? "," : "", si_meta.state_names[s], c->state_bytes[s],
+                state_sum ? (double)c->state_bytes[s] / (double)state_sum : 0.0, c->state_runs[s],
+                c->state_runs[s] ? (double)c->state_bytes[s] / (double)c->state_runs[s] : 0.0);
+    }
+    fprintf(fp, "%s],\n  \"transitions\": [", si_meta.state_count ? "\n  " : "");
+    int first = 1;
+    for (int i = 0; i < si_meta.state_count; ++i) {
+        for (int j = 0; j < si_meta.state_count; ++j) {
+            if (c->transitions[i][j] != 0) {
+                fprintf(fp, "%s\n    { \"from\": \"%s\", \"to\": \"%s\", \"count\": %llu }", first ? "" : ",",
+                        si_meta.state_names[i], si_meta.state_names[j], c->transitions[i][j]);
+                first = 0;
+            }
+        }
+    }
+    fprintf(fp, "%s],\n  \"rules\": [", first ? "" : "\n  ");
+    first = 1;
+    for (int r = 0; r < SI_MAX_RULES; ++r) {
+        if (c->rule_hits[r] == 0) {
+            continue;
+        }
+        const char *name = (r < si_meta.rule_count) ? si_meta.rule_names[r] : "default";  /* Flex's implicit ECHO rule. */
+        fprintf(fp, "%s\n    { \"rule\": %d, \"name\": \"%s\", \"hits\": %llu, \"bytes\": %llu }",
+                first ? "" : ",", r + 1, name, c->rule_hits[r], c->rule_bytes[r]);
+        first = 0;
+    }
+
+    fprintf(fp, "%s],\n  \"vectorize_candidates\": [", first ? "" : "\n  ");
+    int order[SI_MAX_STATES], n = 0;                                /* Long-run states, largest share first. */
+    for (int s = 0; s < si_meta.state_count; ++s) {
+        if (c->state_runs[s] && (double)c->state_bytes[s] / (double)c->state_runs[s] >= SI_VECTOR_MIN_RUN) {
+            int k = n++;
+            while (k > 0 && c->state_bytes[order[k - 1]] < c->state_bytes[s]) {
+                order[k] = order[k - 1];
+                k--;
+            }
+            order[k] = s;
+        }
+    }
+    for (int k = 0; k < n; ++k) {
+        fprintf(fp, "%s\"%s\"", k ? ", " : "", si_meta.state_names[order[k]]);
+    }
+    fprintf(fp, "]\n}\n");
+    if (fp != stderr) {
+        fclose(fp);
+    }
+}
+
+static void si_at_exit(void) {
+    si_write_json(1);
+}
+
+static void si_on_signal(int sig) {
+    signal(sig, si_on_signal);                                      /* System V signal() semantics reset the handler. */
+    si_snapshot_requested = 1;                                      /* Only a flag: stdio is not signal-safe. */
+}
+
+static inline void si_init(const char *tool, const char *const *state_names, int state_count,
+                    const char *const *rule_names, int rule_count) {
+    si_meta.tool = tool;
+    si_meta.state_names = state_names;
+    si_meta.state_count = state_count > SI_MAX_STATES ? SI_MAX_STATES : state_count;
+    si_meta.rule_names = rule_names;
+    si_meta.rule_count = rule_count;
+    atexit(si_at_exit);
+    signal(SIGUSR1, si_on_signal);
+}
+
+#define SI_INIT(tool, states, nstates, rules, nrules) si_init(tool, states, nstates, rules, nrules)
+#define SI_RUN_BEGIN(r)        struct { int state; unsigned long long len; } r = { -1, 0 }
+#define SI_RUN_STEP(r, s, n)   do { if (__builtin_expect((int)(s) != r.state, 0)) { if (r.len) si_state(r.state, r.len); \
+                                    r.state = (int)(s); r.len = 0; } r.len += (n); } while (0)
+#define SI_RUN_END(r)          do { if (r.len) si_state(r.state, r.len); } while (0)
+#define SI_SPAN(s, n)          si_state((int)(s), (unsigned long long)(n))
+#define SI_RULE(r, n)          si_rule((int)(r), (unsigned long long)(n))
+#define SI_BYTES(n)            (si_local.bytes += (unsigned long long)(n))
+#define SI_TIME_BEGIN(t)       SiTimer t = si_timer_begin()
+#define SI_TIME_END(t, kind)   si_timer_end(t, kind)
+#define SI_SUSPEND(v)          SiCounters v = si_suspend()
+#define SI_RESUME(v)           si_resume(&(v))
+#define SI_THREAD_FLUSH()      si_flush()
+
+#else /* !SCANNER_INSTRUMENT */
+
+#define SI_INIT(tool, states, nstates, rules, nrules) ((void)(states), (void)(rules)) /* Keeps the name tables "used". */
+#define SI_RUN_BEGIN(r)        ((void)0)
+#define SI_RUN_STEP(r, s, n)   ((void)0)
+#define SI_RUN_END(r)          ((void)0)
+#define SI_SPAN(s, n)          ((void)0)
+#define SI_RULE(r, n)          ((void)0)
+#define SI_BYTES(n)            ((void)0)
+#define SI_TIME_BEGIN(t)       ((void)0)
+#define SI_TIME_END(t, kind)   ((void)0)
+#define SI_SUSPEND(v)          ((void)0)
+#define SI_RESUME(v)           ((void)0)
+#define SI_THREAD_FLUSH()      ((void)0)
+
+#endif /* SCANNER_INSTRUMENT */
+
+#endif /* SCANNER_INSTRUMENTATION_H */